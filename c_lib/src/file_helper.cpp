@@ -1,5 +1,24 @@
 #include "file_helper.h"
 #include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <poll.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+#include "zlib.h"
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
@@ -8,6 +27,8 @@ namespace htk
     const std::string NOTE_SYMBOL = "#";
     const char SimpleConfig::COMMENT_CHAR = '#';
     const std::string SimpleConfig::WHITE_SPACES = "\n\r\t\v\f ";
+    const char SimpleConfig::SECTION_SEPARATOR = '.';
+    static const CharSet CR_CHARS("\r");
     
     bool SimpleReadCSV(const std::string & file_path, std::vector<std::vector<std::string> >& res, const std::string & delimiter)
     {
@@ -30,7 +51,7 @@ namespace htk
 
             // TODO: trim process
 
-            line = trim(line, "\r");
+            trim_inplace(line, CR_CHARS);
             if (line.empty() || startswith(line, NOTE_SYMBOL))
             {
                 continue;
@@ -47,30 +68,1503 @@ namespace htk
         return true;
     }
 
+    bool MappedFile::Open(const std::string& file_path)
+    {
+        Close();
+        int fd = open(file_path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            close(fd);
+            return false;
+        }
+        // ļ޷ӳ䣬ÿַ
+        if (st.st_size == 0)
+        {
+            close(fd);
+            _data_ = "";
+            return true;
+        }
+        void* addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED)
+        {
+            return false;
+        }
+        madvise(addr, st.st_size, MADV_SEQUENTIAL);
+        _data_ = static_cast<const char*>(addr);
+        _size_ = st.st_size;
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (_size_ > 0)
+        {
+            munmap(const_cast<char*>(_data_), _size_);
+        }
+        _data_ = NULL;
+        _size_ = 0;
+    }
+
+    // [begin, end)вҷָҲʱend
+    static const char* FindDelimiter(const char* begin, const char* end,
+        const std::string& delimiter)
+    {
+        const size_t sep_size = delimiter.size();
+        const char first = delimiter[0];
+        while (static_cast<size_t>(end - begin) >= sep_size)
+        {
+            const char* p = static_cast<const char*>(memchr(begin, first, end - begin - sep_size + 1));
+            if (p == NULL)
+            {
+                break;
+            }
+            if (memcmp(p, delimiter.data(), sep_size) == 0)
+            {
+                return p;
+            }
+            begin = p + 1;
+        }
+        return end;
+    }
+
+    bool MappedCSV::Open(const std::string& file_path, const std::string& delimiter, bool build_index)
+    {
+        Close();
+        if (file_path.empty() || delimiter.empty() || !_file_.Open(file_path))
+        {
+            return false;
+        }
+        _delimiter_ = delimiter;
+
+        const char* data = _file_.data();
+        const char* file_end = data + _file_.size();
+        const char* line = data;
+        while (line < file_end)
+        {
+            const char* line_end = static_cast<const char*>(memchr(line, '\n', file_end - line));
+            const char* next = line_end ? line_end + 1 : file_end;
+            if (line_end == NULL)
+            {
+                line_end = file_end;
+            }
+
+            // SimpleReadCSVһȥ˵\rкע
+            const char* begin = line;
+            while (begin < line_end && *begin == '\r') ++begin;
+            while (line_end > begin && *(line_end - 1) == '\r') --line_end;
+            line = next;
+            if (begin == line_end || (static_cast<size_t>(line_end - begin) >= NOTE_SYMBOL.size() &&
+                memcmp(begin, NOTE_SYMBOL.data(), NOTE_SYMBOL.size()) == 0))
+            {
+                continue;
+            }
+
+            RowInfo row = { static_cast<size_t>(begin - data), static_cast<size_t>(line_end - data), _fields_.size() };
+            _rows_.push_back(row);
+            if (!build_index)
+            {
+                continue;
+            }
+            // splitһĩβָ֮Ŀֶβ
+            const char* field = begin;
+            while (field < line_end)
+            {
+                _fields_.push_back(field - data);
+                field = FindDelimiter(field, line_end, delimiter) + delimiter.size();
+            }
+        }
+        return true;
+    }
+
+    void MappedCSV::Close()
+    {
+        _rows_.clear();
+        _fields_.clear();
+        _file_.Close();
+    }
+
+    StringView MappedCSV::GetField(size_t row, size_t col) const
+    {
+        const RowInfo& info = _rows_[row];
+        size_t index = info.first_field + col;
+        const char* begin = _file_.data() + _fields_[index];
+        const char* end = NULL;
+        if (col + 1 < FieldCount(row))
+        {
+            end = _file_.data() + _fields_[index + 1] - _delimiter_.size();
+        }
+        else
+        {
+            end = FindDelimiter(begin, _file_.data() + info.end, _delimiter_);
+        }
+        return StringView(begin, end - begin);
+    }
+
+    size_t MappedCSV::SplitRow(size_t row, std::vector<StringView>& fields) const
+    {
+        fields.clear();
+        const char* field = _file_.data() + _rows_[row].begin;
+        const char* line_end = _file_.data() + _rows_[row].end;
+        while (field < line_end)
+        {
+            const char* field_end = FindDelimiter(field, line_end, _delimiter_);
+            fields.push_back(StringView(field, field_end - field));
+            field = field_end + _delimiter_.size();
+        }
+        return fields.size();
+    }
+
    
     bool SimpleConfig::LoadConfigFile(const std::string & filename)
     {
-        ifstream *reader = new ifstream(filename.c_str());
-        if (!reader) return false;
+        ifstream reader(filename.c_str());
+        if (!reader.is_open()) return false;
 
         _data_.clear();
-        std::string line, key, value;
-        while (getline(*reader, line))
+        _values_.clear();
+        std::string line, key, value, section;
+        const CharSet white_spaces(WHITE_SPACES);
+        while (getline(reader, line))
         {
-            line = trim(line, "\r");
+            trim_inplace(line, CR_CHARS);
             if (line.empty() || line.find(COMMENT_CHAR) == 0) continue;
 
+            // [section]֮ļ"section."ǰ׺[]صȫ
+            StringView trimmed = trim_view(line, white_spaces);
+            if (trimmed.size() >= 2 && trimmed[0] == '[' && trimmed[trimmed.size() - 1] == ']')
+            {
+                section = trim_view(trimmed.substr(1, trimmed.size() - 2), white_spaces).str();
+                continue;
+            }
+
             size_t equal_pos = line.find('=');
             if (equal_pos == std::string::npos) continue;
             else
             {
-                key = trim(line.substr(0, equal_pos), WHITE_SPACES);
-                value = trim(line.substr(equal_pos + 1, line.length() - equal_pos), WHITE_SPACES);
+                StringView key_view = trim_view(StringView(line).substr(0, equal_pos), white_spaces);
+                StringView value_view = trim_view(StringView(line).substr(equal_pos + 1), white_spaces);
+                key.assign(key_view.data(), key_view.size());
+                value.assign(value_view.data(), value_view.size());
+                if (!section.empty())
+                {
+                    key = section + SECTION_SEPARATOR + key;
+                }
                 _data_.insert(config_data_t::value_type(key, value));
             }
         }
+        BuildValues();
         return true;
     }
 
-}
+    SimpleConfig SimpleConfig::Section(const std::string& section) const
+    {
+        SimpleConfig rev;
+        const std::string prefix = section + SECTION_SEPARATOR;
+        for (config_data_t::const_iterator it = _data_.lower_bound(prefix);
+            it != _data_.end() && startswith(it->first, prefix); ++it)
+        {
+            rev._data_.insert(config_data_t::value_type(it->first.substr(prefix.size()), it->second));
+        }
+        rev.BuildValues();
+        return rev;
+    }
+
+    void SimpleConfig::BuildValues()
+    {
+        _values_.clear();
+        _values_.reserve(_data_.size());
+        for (config_data_t::const_iterator it = _data_.begin(); it != _data_.end(); ++it)
+        {
+            _values_.insert(config_value_t::value_type(it->first, ConfigValue(it->second)));
+        }
+    }
+
+    ReloadableConfig::~ReloadableConfig()
+    {
+        Stop();
+        // ʱӦжȡߣʣĿֱͷ
+        delete _current_.load();
+        for (size_t i = 0; i < _retired_.size(); ++i)
+        {
+            delete _retired_[i];
+        }
+        for (size_t i = 0; i < _draining_.size(); ++i)
+        {
+            delete _draining_[i];
+        }
+    }
+
+    bool ReloadableConfig::Start(const std::string& filename)
+    {
+        Stop();
+        _filename_ = filename;
+        if (!Reload())
+        {
+            return false;
+        }
+        if (pipe(_wake_pipe_) != 0)
+        {
+            return false;
+        }
+        _stopped_.store(false);
+        _watcher_ = new std::thread(&ReloadableConfig::WatchWorker, this);
+        return true;
+    }
+
+    void ReloadableConfig::Stop()
+    {
+        if (_watcher_ == NULL)
+        {
+            return;
+        }
+        _stopped_.store(true);
+        char c = 0;
+        if (write(_wake_pipe_[1], &c, 1) < 0)
+        {
+            // дʧʱ̻߳һγʱʱ˳
+        }
+        _watcher_->join();
+        delete _watcher_;
+        _watcher_ = NULL;
+        close(_wake_pipe_[0]);
+        close(_wake_pipe_[1]);
+    }
+
+    bool ReloadableConfig::Reload()
+    {
+        std::lock_guard<std::mutex> guard(_reload_lock_);
+        SimpleConfig* config = new SimpleConfig();
+        if (!config->LoadConfigFile(_filename_))
+        {
+            delete config;
+            return false;
+        }
+        // ¿ȫ֮ŷɿյȶȡ߽֮
+        const SimpleConfig* old = _current_.exchange(config, std::memory_order_seq_cst);
+        _version_.fetch_add(1, std::memory_order_release);
+        if (old != NULL)
+        {
+            _retired_.push_back(old);
+        }
+        TryReclaim();
+        return true;
+    }
+
+    size_t ReloadableConfig::PendingSnapshots() const
+    {
+        std::lock_guard<std::mutex> guard(_reload_lock_);
+        return _retired_.size() + _draining_.size();
+    }
+
+    bool ReloadableConfig::TryReclaim()
+    {
+        // ȡ߿滻֮ǰ˾ɵ_epoch_лΣ۶Ҫ滻֮һΣ
+        // ˺µĶȡֻܶµָ롣ÿһֻȡ߳ʱпʱ´ټ
+        for (;;)
+        {
+            if (_phase_ == 0)
+            {
+                if (_retired_.empty())
+                {
+                    return false;
+                }
+                _draining_.swap(_retired_);
+                _epoch_.fetch_add(1, std::memory_order_seq_cst);
+                _phase_ = 1;
+            }
+            size_t old_slot = (_epoch_.load(std::memory_order_relaxed) - 1) & 1;
+            if (_readers_[old_slot].load(std::memory_order_seq_cst) != 0)
+            {
+                return true;
+            }
+            if (_phase_ == 1)
+            {
+                _epoch_.fetch_add(1, std::memory_order_seq_cst);
+                _phase_ = 2;
+                continue;
+            }
+            for (size_t i = 0; i < _draining_.size(); ++i)
+            {
+                delete _draining_[i];
+            }
+            _draining_.clear();
+            _phase_ = 0;
+        }
+    }
+
+    void ReloadableConfig::WatchWorker()
+    {
+#ifdef __linux__
+        // ༭ͨдʱļٸǣ˼Ŀ¼ļ
+        // ֻעдɺ͸дһļ
+        size_t slash = _filename_.find_last_of('/');
+        std::string dir = slash == std::string::npos ? "." : _filename_.substr(0, slash + 1);
+        std::string name = slash == std::string::npos ? _filename_ : _filename_.substr(slash + 1);
+        char buffer[4096] __attribute__((aligned(8)));
+        int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd >= 0 && inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+#else
+        int fd = -1;
+#endif
+        struct stat st;
+        time_t last_mtime = stat(_filename_.c_str(), &st) == 0 ? st.st_mtime : 0;
+        while (!_stopped_.load())
+        {
+            struct pollfd fds[2];
+            fds[0].fd = _wake_pipe_[0];
+            fds[0].events = POLLIN;
+            fds[1].fd = fd;
+            fds[1].events = POLLIN;
+            // ûinotifyʱÿһ޸ʱ䣬дյľɿʱÿ10msһλ
+            bool pending;
+            {
+                std::lock_guard<std::mutex> guard(_reload_lock_);
+                pending = TryReclaim();
+            }
+            int timeout = pending ? 10 : (fd >= 0 ? -1 : 1000);
+            int ret = poll(fds, fd >= 0 ? 2 : 1, timeout);
+            if (_stopped_.load())
+            {
+                break;
+            }
+            if (ret < 0)
+            {
+                // ֻStopŽӣźжʱֱµȴԵ֮
+                if (errno != EINTR)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                }
+                continue;
+            }
+            bool changed = false;
+#ifdef __linux__
+            if (fd >= 0 && (fds[1].revents & POLLIN))
+            {
+                ssize_t len = 0;
+                while ((len = read(fd, buffer, sizeof(buffer))) > 0)
+                {
+                    for (char* p = buffer; p < buffer + len;)
+                    {
+                        struct inotify_event* event = reinterpret_cast<struct inotify_event*>(p);
+                        if (event->len > 0 && name == event->name)
+                        {
+                            changed = true;
+                        }
+                        p += sizeof(struct inotify_event) + event->len;
+                    }
+                }
+            }
+#endif
+            if (fd < 0 && stat(_filename_.c_str(), &st) == 0 && st.st_mtime != last_mtime)
+            {
+                last_mtime = st.st_mtime;
+                changed = true;
+            }
+            if (changed)
+            {
+                Reload();
+            }
+        }
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+
+    ConfigValue::ConfigValue(const std::string& raw)
+        : _raw_(raw), _is_int_(false), _is_double_(false), _is_bool_(false),
+        _int_(0), _double_(0), _bool_(false)
+    {
+        _is_int_ = ParseInt64(_raw_, _int_);
+        _is_double_ = ParseDouble(_raw_, _double_);
+        _is_bool_ = ParseBool(_raw_, _bool_);
+        if (!_raw_.empty())
+        {
+            _list_ = split(_raw_, ",", " \t");
+        }
+    }
+
+    std::string CSVField::str(char quote) const
+    {
+        if (!escaped)
+        {
+            return value.str();
+        }
+        std::string rev;
+        rev.reserve(value.size());
+        AppendTo(rev, quote);
+        return rev;
+    }
+
+    void CSVField::AppendTo(std::string& out, char quote) const
+    {
+        if (!escaped)
+        {
+            out.append(value.data(), value.size());
+            return;
+        }
+        for (size_t i = 0; i < value.size(); ++i)
+        {
+            out += value[i];
+            if (value[i] == quote && i + 1 < value.size() && value[i + 1] == quote)
+            {
+                ++i;
+            }
+        }
+    }
+
+    // 64ֽݿšָ()λõλ
+    struct CSVBlockMask
+    {
+        uint64_t quote;
+        uint64_t separator;
+    };
+
+    static void ScalarBlockMask(const char* p, char delimiter, char quote, CSVBlockMask& mask)
+    {
+        mask.quote = 0;
+        mask.separator = 0;
+        for (int i = 0; i < 64; ++i)
+        {
+            if (p[i] == quote) mask.quote |= 1ULL << i;
+            if (p[i] == delimiter || p[i] == '\n') mask.separator |= 1ULL << i;
+        }
+    }
+
+#if defined(__SSE2__)
+    static void SSE2BlockMask(const char* p, char delimiter, char quote, CSVBlockMask& mask)
+    {
+        const __m128i q = _mm_set1_epi8(quote);
+        const __m128i d = _mm_set1_epi8(delimiter);
+        const __m128i n = _mm_set1_epi8('\n');
+        mask.quote = 0;
+        mask.separator = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 16));
+            uint64_t qm = static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, q)));
+            uint64_t sm = static_cast<uint16_t>(_mm_movemask_epi8(
+                _mm_or_si128(_mm_cmpeq_epi8(v, d), _mm_cmpeq_epi8(v, n))));
+            mask.quote |= qm << (i * 16);
+            mask.separator |= sm << (i * 16);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    static void AVX2BlockMask(const char* p, char delimiter, char quote, CSVBlockMask& mask)
+    {
+        const __m256i q = _mm256_set1_epi8(quote);
+        const __m256i d = _mm256_set1_epi8(delimiter);
+        const __m256i n = _mm256_set1_epi8('\n');
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+        uint64_t qlo = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, q)));
+        uint64_t qhi = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, q)));
+        uint64_t slo = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(lo, d), _mm256_cmpeq_epi8(lo, n))));
+        uint64_t shi = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(hi, d), _mm256_cmpeq_epi8(hi, n))));
+        mask.quote = qlo | (qhi << 32);
+        mask.separator = slo | (shi << 32);
+    }
+#endif
+
+    typedef void (*BlockMaskFunc)(const char*, char, char, CSVBlockMask&);
+
+    static BlockMaskFunc SelectBlockMask()
+    {
+#if defined(__SSE2__)
+        // 뵥Ԫľ̬ʼ׶αãҪȳʼCPUϢ
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return AVX2BlockMask;
+        }
+        return SSE2BlockMask;
+#else
+        return ScalarBlockMask;
+#endif
+    }
 
+    // һʹʱѡʵ֣̬ʼ˳
+    static BlockMaskFunc GetBlockMask()
+    {
+        static const BlockMaskFunc block_mask = SelectBlockMask();
+        return block_mask;
+    }
+
+    // ÿһλ֮ǰ(λ)ĿżԣλǷ
+    static inline uint64_t PrefixXor(uint64_t x)
+    {
+        x ^= x << 1;
+        x ^= x << 2;
+        x ^= x << 4;
+        x ^= x << 8;
+        x ^= x << 16;
+        x ^= x << 32;
+        return x;
+    }
+
+    // [begin, end)ֶΣ˶ʱȥ
+    static inline CSVField MakeField(const char* begin, const char* end, char quote)
+    {
+        CSVField field;
+        field.escaped = false;
+        if (quote != '\0' && end - begin >= 2 && *begin == quote && *(end - 1) == quote)
+        {
+            field.value = StringView(begin + 1, end - begin - 2);
+            field.escaped = memchr(begin + 1, quote, end - begin - 2) != NULL;
+        }
+        else
+        {
+            field.value = StringView(begin, end - begin);
+        }
+        return field;
+    }
+
+    // ParseParseRowʵ֣callbackģ룬ParseRowҪstd::function
+    template <typename Callback>
+    static size_t ParseRows(const CSVOptions& opt, const char* data, size_t size,
+        std::vector<CSVField>& row, Callback& callback, bool final)
+    {
+        row.clear();
+        const BlockMaskFunc block_mask = GetBlockMask();
+        // ǰֶκ͵ǰеʼλ
+        size_t field_start = 0;
+        size_t row_start = 0;
+        // һݿʱǷ
+        uint64_t quote_carry = 0;
+        bool check_row_start = true;
+        size_t pos = 0;
+        char tail[64];
+
+        while (pos < size)
+        {
+            // ׼עУעеŲ״̬ļ
+            if (check_row_start)
+            {
+                check_row_start = false;
+                if (opt.comment != '\0' && data[row_start] == opt.comment)
+                {
+                    const char* line_end = static_cast<const char*>(
+                        memchr(data + row_start, '\n', size - row_start));
+                    if (line_end == NULL && !final)
+                    {
+                        return row_start;
+                    }
+                    row_start = field_start = pos = line_end ? line_end - data + 1 : size;
+                    quote_carry = 0;
+                    check_row_start = true;
+                    continue;
+                }
+            }
+
+            const char* block = data + pos;
+            size_t block_size = 64;
+            if (size - pos < 64)
+            {
+                block_size = size - pos;
+                memset(tail, 0, sizeof(tail));
+                memcpy(tail, block, block_size);
+                block = tail;
+            }
+            CSVBlockMask mask;
+            block_mask(block, opt.delimiter, opt.quote, mask);
+            if (opt.quote == '\0')
+            {
+                mask.quote = 0;
+            }
+            if (block_size < 64)
+            {
+                uint64_t valid = (1ULL << block_size) - 1;
+                mask.quote &= valid;
+                mask.separator &= valid;
+            }
+            uint64_t inside = PrefixXor(mask.quote) ^ quote_carry;
+            quote_carry = static_cast<uint64_t>(0) - (inside >> 63);
+            uint64_t structural = mask.separator & ~inside;
+
+            bool restart = false;
+            while (structural)
+            {
+                size_t idx = pos + __builtin_ctzll(structural);
+                structural &= structural - 1;
+
+                const char* begin = data + field_start;
+                const char* end = data + idx;
+                bool newline = data[idx] == '\n';
+                if (newline && end > begin && *(end - 1) == '\r')
+                {
+                    --end;
+                }
+                row.push_back(MakeField(begin, end, opt.quote));
+                field_start = idx + 1;
+                if (!newline)
+                {
+                    continue;
+                }
+
+                bool empty_line = row.size() == 1 && end == data + row_start;
+                if (!(empty_line && opt.skip_empty_lines) && !callback(row))
+                {
+                    return idx + 1;
+                }
+                row.clear();
+                row_start = idx + 1;
+                if (opt.comment != '\0' && row_start < size && data[row_start] == opt.comment)
+                {
+                    // ע֮Ҫµλ¼
+                    check_row_start = true;
+                    pos = row_start;
+                    quote_carry = 0;
+                    restart = true;
+                    break;
+                }
+            }
+            if (!restart)
+            {
+                pos += block_size;
+            }
+        }
+
+        // һûлз
+        if (!final)
+        {
+            return row_start;
+        }
+        if (field_start < size || !row.empty())
+        {
+            const char* begin = data + field_start;
+            const char* end = data + size;
+            if (end > begin && *(end - 1) == '\r')
+            {
+                --end;
+            }
+            row.push_back(MakeField(begin, end, opt.quote));
+            bool empty_line = row.size() == 1 && end == data + row_start;
+            if (!(empty_line && opt.skip_empty_lines))
+            {
+                callback(row);
+            }
+        }
+        return size;
+    }
+
+    size_t CSVParser::Parse(const char* data, size_t size, const RowCallback& callback, bool final) const
+    {
+        std::vector<CSVField> row;
+        return ParseRows(_options_, data, size, row, callback, final);
+    }
+
+    size_t CSVParser::Parse(const char* data, size_t size, std::vector<CSVField>& row,
+        const RowCallback& callback, bool final) const
+    {
+        return ParseRows(_options_, data, size, row, callback, final);
+    }
+
+    size_t CSVParser::ParseRow(const char* data, size_t size, std::vector<CSVField>& row, bool& found,
+        bool final) const
+    {
+        found = false;
+        // صfalseʱParseRowsأrowбľһ
+        auto stop = [&found](const std::vector<CSVField>&) {
+            found = true;
+            return false;
+        };
+        return ParseRows(_options_, data, size, row, stop, final);
+    }
+
+    // ǷҪѹԶʶʱֻgzipͷ
+    // zlibͷֻֽڵУ飬"80""x "ͨıҲͨ˲Զʶ
+    static bool IsCompressedData(const char* data, size_t size, CSVCompression compression)
+    {
+        switch (compression)
+        {
+        case CSV_COMPRESSION_NONE:
+            return false;
+        case CSV_COMPRESSION_GZIP:
+        case CSV_COMPRESSION_ZLIB:
+            return true;
+        default:
+            return size >= 2 && static_cast<unsigned char>(data[0]) == 0x1f &&
+                static_cast<unsigned char>(data[1]) == 0x8b;
+        }
+    }
+
+    // ʽȡѹļ
+    static bool ReadCSVStream(const std::string& file_path, std::vector<std::vector<std::string> >& res, const CSVOptions& options)
+    {
+        CSVReader reader(options);
+        if (!reader.Open(file_path))
+        {
+            return false;
+        }
+        res.clear();
+        reader.ForEach([&](const std::vector<CSVField>& row) {
+            std::vector<std::string> items;
+            items.reserve(row.size());
+            for (size_t i = 0; i < row.size(); ++i)
+            {
+                items.push_back(row[i].str(options.quote));
+            }
+            res.push_back(items);
+            return true;
+        });
+        return !reader.Failed();
+    }
+
+    bool ReadCSV(const std::string& file_path, std::vector<std::vector<std::string> >& res, const CSVOptions& options)
+    {
+        MappedFile file;
+        if (file_path.empty() || !file.Open(file_path))
+        {
+            return false;
+        }
+        if (IsCompressedData(file.data(), file.size(), options.compression))
+        {
+            file.Close();
+            return ReadCSVStream(file_path, res, options);
+        }
+        res.clear();
+        CSVParser parser(options);
+        parser.Parse(file.data(), file.size(), [&](const std::vector<CSVField>& row) {
+            std::vector<std::string> items;
+            items.reserve(row.size());
+            for (size_t i = 0; i < row.size(); ++i)
+            {
+                items.push_back(row[i].str(options.quote));
+            }
+            res.push_back(items);
+            return true;
+        });
+        return true;
+    }
+
+    bool InflateReader::Open(const std::string& file_path, CSVCompression compression)
+    {
+        Close();
+        if (file_path.empty())
+        {
+            return false;
+        }
+        _file_.open(file_path.c_str(), std::ios::in | std::ios::binary);
+        if (!_file_.is_open())
+        {
+            return false;
+        }
+        char head[2];
+        _file_.read(head, 2);
+        _compressed_ = IsCompressedData(head, _file_.gcount(), compression);
+        _file_.clear();
+        _file_.seekg(0);
+        _failed_ = false;
+        if (_compressed_)
+        {
+            _finished_ = false;
+            _stopped_ = false;
+            _worker_ = new std::thread(&InflateReader::InflateWorker, this);
+        }
+        return true;
+    }
+
+    void InflateReader::Close()
+    {
+        if (_worker_)
+        {
+            {
+                std::lock_guard<std::mutex> guard(_lock_);
+                _stopped_ = true;
+            }
+            _cond_.notify_all();
+            _worker_->join();
+            delete _worker_;
+            _worker_ = NULL;
+        }
+        if (_file_.is_open())
+        {
+            _file_.close();
+        }
+        _file_.clear();
+        _full_.clear();
+        _current_.clear();
+        _current_pos_ = 0;
+        _compressed_ = false;
+        _finished_ = true;
+    }
+
+    size_t InflateReader::Read(char* buffer, size_t size)
+    {
+        if (!_compressed_)
+        {
+            if (!_file_.is_open())
+            {
+                return 0;
+            }
+            _file_.read(buffer, size);
+            return _file_.gcount();
+        }
+
+        size_t count = 0;
+        while (count < size)
+        {
+            if (_current_pos_ == _current_.size())
+            {
+                std::unique_lock<std::mutex> guard(_lock_);
+                if (!_current_.empty())
+                {
+                    _free_.push_back(std::vector<char>());
+                    _free_.back().swap(_current_);
+                    _cond_.notify_all();
+                }
+                _current_pos_ = 0;
+                _cond_.wait(guard, [this]() { return !_full_.empty() || _finished_; });
+                if (_full_.empty())
+                {
+                    break;
+                }
+                _current_.swap(_full_.front());
+                _full_.pop_front();
+                _cond_.notify_all();
+            }
+            size_t n = std::min(size - count, _current_.size() - _current_pos_);
+            memcpy(buffer + count, &_current_[_current_pos_], n);
+            _current_pos_ += n;
+            count += n;
+        }
+        return count;
+    }
+
+    void InflateReader::InflateWorker()
+    {
+        // ͬһļпжgzipݶ
+        const size_t MAX_FULL_BLOCKS = 4;
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        // Զʶgzipzlibͷ
+        bool ok = inflateInit2(&stream, 15 + 32) == Z_OK;
+        bool stream_end = false;
+        std::vector<char> input(_block_size_);
+        std::vector<char> output;
+        while (ok)
+        {
+            if (output.empty())
+            {
+                std::lock_guard<std::mutex> guard(_lock_);
+                if (!_free_.empty())
+                {
+                    output.swap(_free_.back());
+                    _free_.pop_back();
+                }
+                output.resize(_block_size_);
+                stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+                stream.avail_out = output.size();
+            }
+            if (stream.avail_in == 0)
+            {
+                _file_.read(&input[0], input.size());
+                size_t n = _file_.gcount();
+                if (n == 0)
+                {
+                    break;
+                }
+                stream.next_in = reinterpret_cast<Bytef*>(&input[0]);
+                stream.avail_in = n;
+            }
+            int ret = inflate(&stream, Z_NO_FLUSH);
+            if (ret == Z_STREAM_END)
+            {
+                stream_end = true;
+                ok = inflateReset(&stream) == Z_OK;
+            }
+            else if (ret == Z_OK || ret == Z_BUF_ERROR)
+            {
+                stream_end = false;
+            }
+            else
+            {
+                ok = false;
+            }
+
+            if (stream.avail_out == 0)
+            {
+                std::unique_lock<std::mutex> guard(_lock_);
+                _cond_.wait(guard, [&]() { return _full_.size() < MAX_FULL_BLOCKS || _stopped_; });
+                if (_stopped_)
+                {
+                    break;
+                }
+                _full_.push_back(std::vector<char>());
+                _full_.back().swap(output);
+                _cond_.notify_all();
+            }
+        }
+        inflateEnd(&stream);
+
+        std::lock_guard<std::mutex> guard(_lock_);
+        if (!output.empty())
+        {
+            output.resize(output.size() - stream.avail_out);
+            if (!output.empty())
+            {
+                _full_.push_back(std::vector<char>());
+                _full_.back().swap(output);
+            }
+        }
+        if (!ok || (!stream_end && !_stopped_))
+        {
+            _failed_ = true;
+        }
+        _finished_ = true;
+        _cond_.notify_all();
+    }
+
+    bool CSVReader::Open(const std::string& file_path)
+    {
+        Close();
+        if (!_input_.Open(file_path, _parser_.options().compression))
+        {
+            return false;
+        }
+        _eof_ = false;
+        return true;
+    }
+
+    void CSVReader::Close()
+    {
+        _input_.Close();
+        _begin_ = _end_ = 0;
+        _eof_ = true;
+    }
+
+    bool CSVReader::Fill()
+    {
+        if (_eof_)
+        {
+            return false;
+        }
+        if (_begin_ > 0)
+        {
+            memmove(&_buffer_[0], &_buffer_[_begin_], _end_ - _begin_);
+            _end_ -= _begin_;
+            _begin_ = 0;
+        }
+        // ˵ǰбȻ
+        if (_end_ == _buffer_.size())
+        {
+            _buffer_.resize(_buffer_.size() * 2);
+        }
+        size_t count = _input_.Read(&_buffer_[_end_], _buffer_.size() - _end_);
+        _end_ += count;
+        if (count == 0)
+        {
+            _eof_ = true;
+        }
+        return count > 0;
+    }
+
+    bool CSVReader::ReadRow(std::vector<CSVField>& fields)
+    {
+        while (true)
+        {
+            bool found = false;
+            size_t consumed = _parser_.ParseRow(&_buffer_[0] + _begin_, _end_ - _begin_, _row_, found, _eof_);
+            _begin_ += consumed;
+            if (found)
+            {
+                fields.swap(_row_);
+                return true;
+            }
+            if (_eof_ || !Fill())
+            {
+                // ļĩβ֮ٽһʣһ
+                if (_begin_ < _end_)
+                {
+                    continue;
+                }
+                return false;
+            }
+        }
+    }
+
+    bool CSVReader::ForEach(const CSVParser::RowCallback& callback)
+    {
+        bool stopped = false;
+        while (true)
+        {
+            size_t consumed = _parser_.Parse(&_buffer_[0] + _begin_, _end_ - _begin_, _row_,
+                [&](const std::vector<CSVField>& row) {
+                    if (!callback(row))
+                    {
+                        stopped = true;
+                        return false;
+                    }
+                    return true;
+                }, _eof_);
+            _begin_ += consumed;
+            if (stopped)
+            {
+                return false;
+            }
+            if (_eof_ || !Fill())
+            {
+                if (_begin_ < _end_)
+                {
+                    continue;
+                }
+                return true;
+            }
+        }
+    }
+
+    bool CSVWriter::Open(const std::string& file_path, int compress_level)
+    {
+        Close();
+        _failed_ = false;
+        _row_fields_ = 0;
+        _first_empty_ = false;
+        _fd_ = open(file_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (_fd_ < 0)
+        {
+            return false;
+        }
+        _buffer_.reserve(_buffer_size_);
+        if (compress_level > 0)
+        {
+            z_stream* stream = new z_stream();
+            // 31ʾgzipʽ
+            if (deflateInit2(stream, std::min(compress_level, 9), Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                delete stream;
+                close(_fd_);
+                _fd_ = -1;
+                return false;
+            }
+            _stream_ = stream;
+            _compressed_.resize(_buffer_size_);
+        }
+        return true;
+    }
+
+    bool CSVWriter::Close()
+    {
+        if (_fd_ < 0)
+        {
+            return !_failed_;
+        }
+        Flush(true);
+        if (_stream_)
+        {
+            deflateEnd(static_cast<z_stream*>(_stream_));
+            delete static_cast<z_stream*>(_stream_);
+            _stream_ = NULL;
+        }
+        if (close(_fd_) != 0)
+        {
+            _failed_ = true;
+        }
+        _fd_ = -1;
+        return !_failed_;
+    }
+
+    void CSVWriter::WriteOut(const char* data, size_t size)
+    {
+        while (size > 0 && !_failed_)
+        {
+            ssize_t n = write(_fd_, data, size);
+            if (n < 0)
+            {
+                if (errno == EINTR) continue;
+                _failed_ = true;
+                return;
+            }
+            data += n;
+            size -= n;
+        }
+    }
+
+    void CSVWriter::Flush(bool finish)
+    {
+        if (_fd_ < 0)
+        {
+            return;
+        }
+        if (_stream_ == NULL)
+        {
+            WriteOut(_buffer_.data(), _buffer_.size());
+            _buffer_.clear();
+            return;
+        }
+        z_stream* stream = static_cast<z_stream*>(_stream_);
+        stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(_buffer_.data()));
+        stream->avail_in = _buffer_.size();
+        int ret = Z_OK;
+        do
+        {
+            stream->next_out = reinterpret_cast<Bytef*>(&_compressed_[0]);
+            stream->avail_out = _compressed_.size();
+            ret = deflate(stream, finish ? Z_FINISH : Z_NO_FLUSH);
+            if (ret == Z_STREAM_ERROR)
+            {
+                _failed_ = true;
+                break;
+            }
+            WriteOut(&_compressed_[0], _compressed_.size() - stream->avail_out);
+        } while (stream->avail_out == 0 || (finish && ret != Z_STREAM_END));
+        _buffer_.clear();
+    }
+
+    void CSVWriter::WriteField(const StringView& field)
+    {
+        const char quote = _options_.quote;
+        bool need_quote = false;
+        if (quote != '\0')
+        {
+            for (const char* p = field.begin(); p < field.end(); ++p)
+            {
+                char c = *p;
+                if (c == _options_.delimiter || c == quote || c == '\n' || c == '\r')
+                {
+                    need_quote = true;
+                    break;
+                }
+            }
+        }
+        Reserve(field.size() * (need_quote ? 2 : 1) + 3);
+        _first_empty_ = _row_fields_ == 0 && field.empty();
+        BeginField();
+        if (!need_quote)
+        {
+            _buffer_.append(field.data(), field.size());
+            return;
+        }
+        _buffer_ += quote;
+        const char* begin = field.begin();
+        for (const char* p = begin; p < field.end(); ++p)
+        {
+            if (*p == quote)
+            {
+                _buffer_.append(begin, p + 1 - begin);
+                _buffer_ += quote;
+                begin = p + 1;
+            }
+        }
+        _buffer_.append(begin, field.end() - begin);
+        _buffer_ += quote;
+    }
+
+    void CSVWriter::WriteInt(int64_t value)
+    {
+        char temp[32];
+        size_t len = FormatInt64(value, temp);
+        Reserve(len + 1);
+        BeginField();
+        _buffer_.append(temp, len);
+    }
+
+    void CSVWriter::WriteUInt(uint64_t value)
+    {
+        char temp[32];
+        size_t len = FormatUInt64(value, temp);
+        Reserve(len + 1);
+        BeginField();
+        _buffer_.append(temp, len);
+    }
+
+    void CSVWriter::WriteDouble(double value)
+    {
+        char temp[32];
+        size_t len = FormatDouble(value, temp);
+        Reserve(len + 1);
+        BeginField();
+        _buffer_.append(temp, len);
+    }
+
+    void CSVWriter::WriteBool(bool value)
+    {
+        Reserve(6);
+        BeginField();
+        _buffer_.append(value ? "true" : "false");
+    }
+
+    void CSVWriter::EndRow()
+    {
+        Reserve(3);
+        // ֻһֶεлᱻɿҪд""
+        if (_row_fields_ == 1 && _first_empty_ && _options_.quote != '\0')
+        {
+            _buffer_ += _options_.quote;
+            _buffer_ += _options_.quote;
+        }
+        _buffer_ += '\n';
+        _row_fields_ = 0;
+        _first_empty_ = false;
+    }
+
+    void CSVWriter::WriteRow(const std::vector<std::string>& row)
+    {
+        for (size_t i = 0; i < row.size(); ++i)
+        {
+            WriteField(row[i]);
+        }
+        EndRow();
+    }
+
+    bool CSVColumns::Load(const std::string& file_path, const std::vector<CSVColumnSpec>& schema,
+        const CSVOptions& options, bool has_header)
+    {
+        _row_count_ = 0;
+        _columns_.clear();
+        CSVReader reader(options);
+        if (!reader.Open(file_path))
+        {
+            return false;
+        }
+        for (size_t i = 0; i < schema.size(); ++i)
+        {
+            _columns_.push_back(CSVColumn(schema[i]));
+            if (schema[i].type == CSV_STRING)
+            {
+                _columns_.back()._offsets_.push_back(0);
+            }
+        }
+
+        bool header = has_header;
+        reader.ForEach([&](const std::vector<CSVField>& row) {
+            if (header)
+            {
+                header = false;
+                for (size_t i = 0; i < _columns_.size(); ++i)
+                {
+                    size_t index = _columns_[i]._spec_.index;
+                    if (index < row.size())
+                    {
+                        _columns_[i]._name_ = row[index].str(options.quote);
+                    }
+                }
+                return true;
+            }
+            for (size_t i = 0; i < _columns_.size(); ++i)
+            {
+                CSVColumn& column = _columns_[i];
+                size_t index = column._spec_.index;
+                bool valid = index < row.size();
+                StringView field;
+                // תŲںϷֵУֱֵʹԭʼ
+                if (valid)
+                {
+                    field = row[index].value;
+                }
+                switch (column._spec_.type)
+                {
+                case CSV_INT64:
+                {
+                    int64_t number = 0;
+                    valid = valid && ParseInt64(field, number);
+                    column._ints_.push_back(valid ? number : 0);
+                    break;
+                }
+                case CSV_DOUBLE:
+                {
+                    double number = 0;
+                    valid = valid && ParseDouble(field, number);
+                    column._doubles_.push_back(valid ? number : 0);
+                    break;
+                }
+                case CSV_BOOL:
+                {
+                    bool flag = false;
+                    valid = valid && ParseBool(field, flag);
+                    column._bools_.push_back(valid && flag);
+                    break;
+                }
+                case CSV_STRING:
+                    if (valid)
+                    {
+                        row[index].AppendTo(column._arena_, options.quote);
+                    }
+                    column._offsets_.push_back(column._arena_.size());
+                    break;
+                }
+                column._valid_.push_back(valid);
+            }
+            ++_row_count_;
+            return true;
+        });
+        // ѹ𻵻򱻽ضʱֻһ֣ܵɹ
+        return !reader.Failed();
+    }
+
+    // ÿٵֽСļеù
+    static const size_t MIN_CHUNK_SIZE = 1 << 20;
+
+    // in_quote״̬beginʼend֮Ƿ
+    // עֻףеŲ
+    static bool QuoteStateAfter(const char* begin, const char* end, bool in_quote, const CSVOptions& options)
+    {
+        if (options.comment == '\0')
+        {
+            return in_quote ^ (std::count(begin, end, options.quote) % 2 == 1);
+        }
+        while (begin < end)
+        {
+            const char* line_end = static_cast<const char*>(memchr(begin, '\n', end - begin));
+            line_end = line_end ? line_end + 1 : end;
+            if (in_quote || *begin != options.comment)
+            {
+                in_quote ^= std::count(begin, line_end, options.quote) % 2 == 1;
+            }
+            begin = line_end;
+        }
+        return in_quote;
+    }
+
+    // ӴڵλÿʼĵһУһе
+    static size_t SkipQuotedRecord(const char* data, size_t size, size_t pos, char quote)
+    {
+        bool in_quote = true;
+        for (; pos < size; ++pos)
+        {
+            if (data[pos] == quote)
+            {
+                in_quote = !in_quote;
+            }
+            else if (data[pos] == '\n' && !in_quote)
+            {
+                return pos + 1;
+            }
+        }
+        return size;
+    }
+
+    bool ParallelParseCSV(const char* data, size_t size, const CSVOptions& options, const ChunkRowCallback& callback, int thread_num)
+    {
+        if (thread_num <= 0)
+        {
+            thread_num = std::max(1u, std::thread::hardware_concurrency());
+        }
+        size_t chunk_num = std::min<size_t>(thread_num, size / MIN_CHUNK_SIZE + 1);
+
+        // ֽп飬׶뵽
+        std::vector<size_t> starts(chunk_num + 1, size);
+        starts[0] = 0;
+        for (size_t i = 1; i < chunk_num; ++i)
+        {
+            size_t pos = std::max(size / chunk_num * i, starts[i - 1]);
+            const char* line_end = static_cast<const char*>(memchr(data + pos, '\n', size - pos));
+            starts[i] = line_end ? line_end - data + 1 : size;
+        }
+
+        std::vector<std::thread*> thread_list;
+        // һֱÿڿʼʱ״̬
+        // ٴӵһ鿪ʼƵÿǷ
+        std::vector<char> quote_after(chunk_num * 2, 0);
+        if (options.quote != '\0')
+        {
+            for (size_t i = 0; i + 1 < chunk_num; ++i)
+            {
+                thread_list.push_back(new std::thread([&, i]() {
+                    quote_after[i * 2] = QuoteStateAfter(data + starts[i], data + starts[i + 1], false, options);
+                    quote_after[i * 2 + 1] = QuoteStateAfter(data + starts[i], data + starts[i + 1], true, options);
+                }));
+            }
+            for (size_t i = 0; i < thread_list.size(); ++i)
+            {
+                thread_list[i]->join();
+                delete thread_list[i];
+            }
+            thread_list.clear();
+            bool in_quote = false;
+            for (size_t i = 1; i < chunk_num; ++i)
+            {
+                in_quote = quote_after[(i - 1) * 2 + in_quote];
+                if (in_quote)
+                {
+                    starts[i] = SkipQuotedRecord(data, size, starts[i], options.quote);
+                }
+            }
+            for (size_t i = chunk_num - 1; i > 0; --i)
+            {
+                starts[i] = std::min(starts[i], starts[i + 1]);
+            }
+        }
+
+        // ڶ鲢н
+        std::atomic<bool> stopped(false);
+        for (size_t i = 0; i < chunk_num; ++i)
+        {
+            thread_list.push_back(new std::thread([&, i]() {
+                CSVParser parser(options);
+                parser.Parse(data + starts[i], starts[i + 1] - starts[i],
+                    [&](const std::vector<CSVField>& row) {
+                        if (stopped.load(std::memory_order_relaxed) || !callback(i, row))
+                        {
+                            stopped.store(true);
+                            return false;
+                        }
+                        return true;
+                    });
+            }));
+        }
+        for (size_t i = 0; i < thread_list.size(); ++i)
+        {
+            thread_list[i]->join();
+            delete thread_list[i];
+        }
+        return !stopped.load();
+    }
+
+    bool ParallelReadCSV(const std::string& file_path, std::vector<std::vector<std::string> >& res, const CSVOptions& options, int thread_num)
+    {
+        MappedFile file;
+        if (file_path.empty() || !file.Open(file_path))
+        {
+            return false;
+        }
+        if (IsCompressedData(file.data(), file.size(), options.compression))
+        {
+            file.Close();
+            return ReadCSVStream(file_path, res, options);
+        }
+        if (thread_num <= 0)
+        {
+            thread_num = std::max(1u, std::thread::hardware_concurrency());
+        }
+        std::vector<std::vector<std::vector<std::string> > > chunk_rows(thread_num);
+        ParallelParseCSV(file.data(), file.size(), options,
+            [&](size_t chunk, const std::vector<CSVField>& row) {
+                std::vector<std::string> items;
+                items.reserve(row.size());
+                for (size_t i = 0; i < row.size(); ++i)
+                {
+                    items.push_back(row[i].str(options.quote));
+                }
+                chunk_rows[chunk].push_back(std::move(items));
+                return true;
+            }, thread_num);
+
+        res.clear();
+        size_t total = 0;
+        for (size_t i = 0; i < chunk_rows.size(); ++i)
+        {
+            total += chunk_rows[i].size();
+        }
+        res.reserve(total);
+        for (size_t i = 0; i < chunk_rows.size(); ++i)
+        {
+            std::move(chunk_rows[i].begin(), chunk_rows[i].end(), std::back_inserter(res));
+            std::vector<std::vector<std::string> >().swap(chunk_rows[i]);
+        }
+        return true;
+    }
+
+}
@@ -4,6 +4,17 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <type_traits>
+#include <limits>
+#include <functional>
+#include <fstream>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <utility>
 #include "str_helper.h"
 
 namespace htk
@@ -14,12 +25,505 @@ namespace htk
         const std::string& delimiter
     );
 
+    /* ֻڴӳļ */
+    class MappedFile
+    {
+    public:
+        MappedFile() : _data_(NULL), _size_(0) {}
+        ~MappedFile() { Close(); }
+
+        bool Open(const std::string& file_path);
+        void Close();
+
+        const char* data() const { return _data_; }
+        size_t size() const { return _size_; }
+
+    private:
+        MappedFile(const MappedFile&);
+        MappedFile& operator=(const MappedFile&);
+
+        const char* _data_;
+        size_t _size_;
+    };
+
+    /* ڴӳ㿽CSVȡкֶζָӳڴStringView
+     * кͷеĹSimpleReadCSVͬMappedCSV֮StringViewʧЧ */
+    class MappedCSV
+    {
+    public:
+        MappedCSV() {}
+        MappedCSV(const std::string& file_path, const std::string& delimiter,
+            bool build_index = true)
+        {
+            Open(file_path, delimiter, build_index);
+        }
+
+        // build_indexΪtrueʱ¼ÿֶελãֱӰзֶ
+        bool Open(const std::string& file_path, const std::string& delimiter,
+            bool build_index = true);
+        void Close();
+
+        size_t RowCount() const { return _rows_.size(); }
+        StringView GetRow(size_t row) const
+        {
+            return StringView(_file_.data() + _rows_[row].begin,
+                _rows_[row].end - _rows_[row].begin);
+        }
+
+        // Ҫֶ
+        size_t FieldCount(size_t row) const
+        {
+            size_t next = row + 1 < _rows_.size() ? _rows_[row + 1].first_field : _fields_.size();
+            return next - _rows_[row].first_field;
+        }
+        StringView GetField(size_t row, size_t col) const;
+
+        // ֶзһУֶĿ
+        size_t SplitRow(size_t row, std::vector<StringView>& fields) const;
+
+    private:
+        struct RowInfo
+        {
+            size_t begin;
+            size_t end;
+            size_t first_field;
+        };
+
+        MappedFile _file_;
+        std::string _delimiter_;
+        std::vector<RowInfo> _rows_;
+        // ÿֶεʼλ
+        std::vector<size_t> _fields_;
+    };
+
+    /* ļѹʽ */
+    enum CSVCompression
+    {
+        // gzipͷ(1f 8b)ʼʱѹԭʼݶȡ
+        CSV_COMPRESSION_AUTO,
+        CSV_COMPRESSION_NONE,
+        CSV_COMPRESSION_GZIP,
+        // gzipͷzlibͨı޷ɿֻ֣ʽָ
+        CSV_COMPRESSION_ZLIB
+    };
+
+    /* CSVѡ */
+    struct CSVOptions
+    {
+        CSVOptions() : delimiter(','), quote('"'), comment('\0'), skip_empty_lines(true),
+            compression(CSV_COMPRESSION_AUTO) {}
+
+        char delimiter;
+        // ַ'\0'ʾ
+        char quote;
+        // ԸַͷΪע'\0'ʾSimpleReadCSVһʱΪ'#'
+        char comment;
+        bool skip_empty_lines;
+        // ȡļʱʹãڴеݲѹ
+        CSVCompression compression;
+    };
+
+    /* CSVֶΣvalueָ򱻽 */
+    struct CSVField
+    {
+        // ȥ֮
+        StringView value;
+        // кת("")Ҫstr()õԭֶ
+        bool escaped;
+
+        std::string str(char quote = '"') const;
+        // ѻԭֶ׷ӵoutĩβ
+        void AppendTo(std::string& out, char quote = '"') const;
+    };
+
+    /* RFC-4180CSV֧ڵķָкת
+     * ʹSSE2/AVX2ҷָźͻУ֧ʱʹñʵ */
+    class CSVParser
+    {
+    public:
+        // falseʱֹͣ
+        typedef std::function<bool(const std::vector<CSVField>&)> RowCallback;
+
+        CSVParser(const CSVOptions& options = CSVOptions()) : _options_(options) {}
+
+        // [data, data + size)ÿһеcallback
+        // ѴֽcallbackֹʱΪн֮λ
+        // finalΪfalseʱݻδĩβûлевصֵΪеʼλ
+        size_t Parse(const char* data, size_t size, const RowCallback& callback, bool final = true) const;
+        // ͬϣrowɵṩڽУε֮Ըڴ
+        size_t Parse(const char* data, size_t size, std::vector<CSVField>& row,
+            const RowCallback& callback, bool final = true) const;
+        // ֻһУrowУfoundʾǷһУֵĺParseͬ
+        size_t ParseRow(const char* data, size_t size, std::vector<CSVField>& row, bool& found,
+            bool final = true) const;
+
+        const CSVOptions& options() const { return _options_; }
+
+    private:
+        CSVOptions _options_;
+    };
+
+    /* ˳ȡļָѹʽѹĬֻԶʶgzipఴԭʼݶȡ
+     * ѹں̨߳нУߵĴص໺4ѹݿ */
+    class InflateReader
+    {
+    public:
+        InflateReader(size_t block_size = 1 << 20)
+            : _block_size_(block_size), _compressed_(false), _worker_(NULL),
+            _current_pos_(0), _finished_(true), _stopped_(false), _failed_(false) {}
+        ~InflateReader() { Close(); }
+
+        bool Open(const std::string& file_path, CSVCompression compression = CSV_COMPRESSION_AUTO);
+        void Close();
+
+        // ȡsizeֽڵݣ0ʾѾ
+        size_t Read(char* buffer, size_t size);
+        bool IsCompressed() const { return _compressed_; }
+        // ѹ𻵻߱ض
+        bool Failed() const { return _failed_; }
+
+    private:
+        InflateReader(const InflateReader&);
+        InflateReader& operator=(const InflateReader&);
+
+        // ̨ѹ߳
+        void InflateWorker();
+
+        size_t _block_size_;
+        std::ifstream _file_;
+        bool _compressed_;
+        std::thread* _worker_;
+        std::mutex _lock_;
+        std::condition_variable _cond_;
+        // ѽѹȴȡݿ飬ԼԸõݿ
+        std::deque<std::vector<char> > _full_;
+        std::vector<std::vector<char> > _free_;
+        // ڶȡݿ
+        std::vector<char> _current_;
+        size_t _current_pos_;
+        bool _finished_;
+        bool _stopped_;
+        bool _failed_;
+    };
+
+    /* ʽȡCSVڹ̶СĻȡͽڴռļС޹
+     * ֻڵгСʱ󣬰options.compressionѹѹļ */
+    class CSVReader
+    {
+    public:
+        CSVReader(const CSVOptions& options = CSVOptions(), size_t buffer_size = 1 << 20)
+            : _parser_(options), _buffer_(buffer_size > 64 ? buffer_size : 64), _begin_(0), _end_(0), _eof_(true) {}
+        ~CSVReader() { Close(); }
+
+        bool Open(const std::string& file_path);
+        void Close();
+
+        // ȡһУfieldsеֶָڲһζȡ֮ʧЧ
+        // fieldsڲл彻ͬһvectorʱٷڴ棬ļʱfalse
+        bool ReadRow(std::vector<CSVField>& fields);
+        // ʣÿһеcallbackcallbackfalseʱֹͣfalse
+        bool ForEach(const CSVParser::RowCallback& callback);
+        // ѹ𻵣ݲ
+        bool Failed() const { return _input_.Failed(); }
+
+    private:
+        CSVReader(const CSVReader&);
+        CSVReader& operator=(const CSVReader&);
+
+        // δƵͷݣûжʱfalse
+        bool Fill();
+
+        CSVParser _parser_;
+        InflateReader _input_;
+        std::vector<char> _buffer_;
+        // δݵķΧ
+        size_t _begin_;
+        size_t _end_;
+        bool _eof_;
+        // ǰʹõĻ壬֮临
+        std::vector<CSVField> _row_;
+    };
+
+    /* CSVд룬ֱֵӸʽֶֻںзָŻʱż
+     * Աд߽gzipѹ */
+    class CSVWriter
+    {
+    public:
+        CSVWriter(const CSVOptions& options = CSVOptions(), size_t buffer_size = 1 << 20)
+            : _options_(options), _buffer_size_(buffer_size > 64 ? buffer_size : 64),
+            _fd_(-1), _stream_(NULL), _row_fields_(0), _first_empty_(false), _failed_(false) {}
+        ~CSVWriter() { Close(); }
+
+        // compress_levelΪ0ʱѹ1~9Ϊgzipѹ
+        bool Open(const std::string& file_path, int compress_level = 0);
+        // дʣݲرļдгʱfalse
+        bool Close();
+
+        void WriteField(const StringView& field);
+        void WriteInt(int64_t value);
+        void WriteUInt(uint64_t value);
+        void WriteDouble(double value);
+        void WriteBool(bool value);
+        // ǰУ\n
+        void EndRow();
+        void WriteRow(const std::vector<std::string>& row);
+
+        bool Failed() const { return _failed_; }
+
+    private:
+        CSVWriter(const CSVWriter&);
+        CSVWriter& operator=(const CSVWriter&);
+
+        // ֤sizeֽڵĿռ
+        void Reserve(size_t size)
+        {
+            if (_buffer_.size() + size > _buffer_size_)
+            {
+                Flush(false);
+            }
+        }
+        // ֶ֮ӷָ
+        void BeginField()
+        {
+            if (_row_fields_ > 0)
+            {
+                _buffer_ += _options_.delimiter;
+            }
+            ++_row_fields_;
+        }
+        void Flush(bool finish);
+        void WriteOut(const char* data, size_t size);
+
+        CSVOptions _options_;
+        size_t _buffer_size_;
+        std::string _buffer_;
+        std::vector<char> _compressed_;
+        int _fd_;
+        // zlibz_streamѹʱΪNULL
+        void* _stream_;
+        // ǰѾдֶԼһֶǷΪ
+        size_t _row_fields_;
+        bool _first_empty_;
+        bool _failed_;
+    };
+
+    /* ʽCSVʱ */
+    enum CSVColumnType
+    {
+        CSV_INT64,
+        CSV_DOUBLE,
+        CSV_BOOL,
+        CSV_STRING
+    };
+
+    /* ʽصж壬indexΪCSVеλ */
+    struct CSVColumnSpec
+    {
+        size_t index;
+        CSVColumnType type;
+    };
+
+    /* 洢һݣֻͶӦ
+     * ַеδͬһڴУiΪ[offsets[i], offsets[i + 1]) */
+    class CSVColumn
+    {
+    public:
+        CSVColumn(const CSVColumnSpec& spec) : _spec_(spec) {}
+
+        const CSVColumnSpec& spec() const { return _spec_; }
+        const std::string& name() const { return _name_; }
+        size_t size() const { return _valid_.size(); }
+        // ֶȱʧ޷תΪʱЧӦֵΪ0ַ
+        bool IsValid(size_t row) const { return _valid_[row]; }
+
+        const std::vector<int64_t>& ints() const { return _ints_; }
+        const std::vector<double>& doubles() const { return _doubles_; }
+        const std::vector<uint8_t>& bools() const { return _bools_; }
+        StringView GetString(size_t row) const
+        {
+            return StringView(_arena_.data() + _offsets_[row], _offsets_[row + 1] - _offsets_[row]);
+        }
+
+    private:
+        friend class CSVColumns;
+
+        CSVColumnSpec _spec_;
+        std::string _name_;
+        std::vector<bool> _valid_;
+        std::vector<int64_t> _ints_;
+        std::vector<double> _doubles_;
+        std::vector<uint8_t> _bools_;
+        std::string _arena_;
+        std::vector<size_t> _offsets_;
+    };
+
+    /* мCSVֱֶӽӦ͵УΪÿֶηڴ */
+    class CSVColumns
+    {
+    public:
+        CSVColumns() : _row_count_(0) {}
+
+        // has_headerΪtrueʱһΪļ޷򿪻ѹʱfalse
+        bool Load(const std::string& file_path, const std::vector<CSVColumnSpec>& schema,
+            const CSVOptions& options = CSVOptions(), bool has_header = false);
+
+        size_t RowCount() const { return _row_count_; }
+        size_t ColumnCount() const { return _columns_.size(); }
+        // iаschemaе˳
+        const CSVColumn& Column(size_t i) const { return _columns_[i]; }
+
+    private:
+        size_t _row_count_;
+        std::vector<CSVColumn> _columns_;
+    };
+
+    /* ̷ֿ߳CSVȲмʱ״̬ȷǷڣ
+     * ٰѿ׶뵽ף鲢н
+     * callbackڹ߳еãͬһڰе˳ص֮ͬ䲢falseʱֹ߳ͣ */
+    typedef std::function<bool(size_t chunk, const std::vector<CSVField>& row)> ChunkRowCallback;
+    bool ParallelParseCSV(
+        const char* data,
+        size_t size,
+        const CSVOptions& options,
+        const ChunkRowCallback& callback,
+        int thread_num = 0
+    );
+
+    /* ̶߳ȡCSVļļе˳Уthread_numΪ0ʱʹк
+     * ѹļ޷ֿ飬˻ΪReadCSV */
+    bool ParallelReadCSV(
+        const std::string& file_path,
+        std::vector< std::vector<std::string> >& res,
+        const CSVOptions& options = CSVOptions(),
+        int thread_num = 0
+    );
+
+    /* ʹCSVParserȡCSVļoptions.compressionѹѹļ */
+    bool ReadCSV(
+        const std::string& file_path,
+        std::vector< std::vector<std::string> >& res,
+        const CSVOptions& options = CSVOptions()
+    );
+
+    class ConfigValue;
+
+    /* ConfigValueתΪTֵַַбֱʹԤȽĽ
+     * ͡ԤȽʧԼTķΧʱʹConvertFromString */
+    template<typename T, typename Enable = void>
+    struct ConfigValueCast
+    {
+        static T cast(const ConfigValue& value);
+    };
+
+    /* ԤȽֵʱһΣ֮ȡٽ
+     * ֵͲֵĶȡڴ棻as<std::string>ȰֵػḴƣҪ⸴ʱʹstr()AsList() */
+    class ConfigValue
+    {
+    public:
+        ConfigValue() : _is_int_(false), _is_double_(false), _is_bool_(false),
+            _int_(0), _double_(0), _bool_(false) {}
+        explicit ConfigValue(const std::string& raw);
+
+        const std::string& str() const { return _raw_; }
+        bool IsInt() const { return _is_int_; }
+        bool IsDouble() const { return _is_double_; }
+        bool IsBool() const { return _is_bool_; }
+
+        int64_t AsInt() const { return _int_; }
+        double AsDouble() const { return _double_; }
+        bool AsBool() const { return _bool_; }
+        // ŷָȥ˿հ֮б
+        const std::vector<std::string>& AsList() const { return _list_; }
+
+        template<typename T>
+        T as() const
+        {
+            return ConfigValueCast<T>::cast(*this);
+        }
+
+    private:
+        std::string _raw_;
+        bool _is_int_;
+        bool _is_double_;
+        bool _is_bool_;
+        int64_t _int_;
+        double _double_;
+        bool _bool_;
+        std::vector<std::string> _list_;
+    };
+
+    template<typename T, typename Enable>
+    T ConfigValueCast<T, Enable>::cast(const ConfigValue& value)
+    {
+        return ConvertFromString<T>(value.str());
+    }
+
+    template<typename T>
+    struct ConfigValueCast<T, typename std::enable_if<std::is_integral<T>::value &&
+        !std::is_same<T, bool>::value>::type>
+    {
+        static T cast(const ConfigValue& value)
+        {
+            return value.IsInt() && InRange(value.AsInt()) ? static_cast<T>(value.AsInt()) : ConvertFromString<T>(value.str());
+        }
+
+        // ֱתضϣΧʱConvertFromString
+        static bool InRange(int64_t number)
+        {
+            if (std::is_signed<T>::value)
+            {
+                return number >= static_cast<int64_t>(std::numeric_limits<T>::min()) &&
+                    number <= static_cast<int64_t>(std::numeric_limits<T>::max());
+            }
+            return number >= 0 && static_cast<uint64_t>(number) <= static_cast<uint64_t>(std::numeric_limits<T>::max());
+        }
+    };
+
+    template<typename T>
+    struct ConfigValueCast<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+    {
+        static T cast(const ConfigValue& value)
+        {
+            return value.IsDouble() ? static_cast<T>(value.AsDouble()) : ConvertFromString<T>(value.str());
+        }
+    };
+
+    template<>
+    struct ConfigValueCast<bool>
+    {
+        static bool cast(const ConfigValue& value)
+        {
+            return value.IsBool() ? value.AsBool() : ConvertFromString<bool>(value.str());
+        }
+    };
+
+    template<>
+    struct ConfigValueCast<std::string>
+    {
+        static std::string cast(const ConfigValue& value)
+        {
+            return value.str();
+        }
+    };
+
+    template<>
+    struct ConfigValueCast< std::vector<std::string> >
+    {
+        static std::vector<std::string> cast(const ConfigValue& value)
+        {
+            return value.AsList();
+        }
+    };
+
     class SimpleConfig
     {
         static const char COMMENT_CHAR;
         static const std::string WHITE_SPACES;
+        static const char SECTION_SEPARATOR;
 
         typedef std::map<std::string, std::string> config_data_t;
+        // ָ_data_еļstd::mapĽڵַ䣬ʱҪؽ
+        typedef std::unordered_map<StringView, ConfigValue, StringViewHash> config_value_t;
 
     public:
         SimpleConfig() {}
@@ -27,71 +531,287 @@ namespace htk
         {
             LoadConfigFile(filename);
         }
+        SimpleConfig(const SimpleConfig& other) : _data_(other._data_)
+        {
+            BuildValues();
+        }
+        SimpleConfig& operator=(const SimpleConfig& other)
+        {
+            if (this != &other)
+            {
+                _data_ = other._data_;
+                BuildValues();
+            }
+            return *this;
+        }
+        // ƶʱڵתƣȻЧ
+        SimpleConfig(SimpleConfig&& other) = default;
+        SimpleConfig& operator=(SimpleConfig&& other) = default;
         ~SimpleConfig() {}
 
+        // ʱstd::stringֵص(std::string)Ḵƣ
+        // ҪʱʹGetValue(key).str()GetValue(key).AsList()
         template<typename T>
-        T get(const std::string& key)
+        T get(const StringView& key) const
         {
-            config_data_t::iterator it = _data_.find(key);
-            if (it == _data_.end())
-            {
-                printf("error: can`t find config key \"%s\"", key.c_str());
-                exit(404);
-            }
-            return ConvertFromString<T>(it->second);
+            return GetValue(key).as<T>();
         }
 
         template<typename T>
-        T get(const std::string& key, const T& default_value)
+        T get(const StringView& key, const T& default_value) const
         {
-            config_data_t::iterator it = _data_.find(key);
-            if (it == _data_.end())
+            const ConfigValue* value = Find(key);
+            if (value == NULL)
             {
                 return default_value;
             }
-            return ConvertFromString<T>(it->second);
+            return value->as<T>();
         }
 
         template<typename T>
-        bool get(const std::string& key, T& rev)
+        bool get(const StringView& key, T& rev) const
         {
-            config_data_t::iterator it = _data_.find(key);
-            if (it == _data_.end())
+            const ConfigValue* value = Find(key);
+            if (value == NULL)
             {
                 return false;
             }
             else
             {
-                rev = ConvertFromString<T>(it->second);
+                rev = value->as<T>();
                 return true;
             }
         }
 
         template<typename T>
-        bool get(const std::string& key, const T& default_value, T& rev)
+        bool get(const StringView& key, const T& default_value, T& rev) const
         {
-            config_data_t::iterator it = _data_.find(key);
-            if (it == _data_.end())
+            const ConfigValue* value = Find(key);
+            if (value == NULL)
             {
                 rev = default_value;
             }
             else
             {
-                get(key, rev);
+                rev = value->as<T>();
             }
             return true;
         }
 
+        // ԤȽֵҲʱNULL
+        // صָ¼֮ǰһֱЧȵԱظʹ
+        const ConfigValue* Find(const StringView& key) const
+        {
+            config_value_t::const_iterator it = _values_.find(key);
+            return it == _values_.end() ? NULL : &it->second;
+        }
+
+        // getͬʱ˳
+        const ConfigValue& GetValue(const StringView& key) const
+        {
+            const ConfigValue* value = Find(key);
+            if (value == NULL)
+            {
+                printf("error: can`t find config key \"%.*s\"", static_cast<int>(key.size()), key.data());
+                exit(404);
+            }
+            return *value;
+        }
+
+        // ֧INI[section]еļ"section.key"ʽ棬section԰'.'
         bool LoadConfigFile(const std::string& filename);
 
-        const std::map<std::string, std::string>& GetData()
+        // ȡĳsection(Ƕ׵section)µãȥ"section."ǰ׺
+        SimpleConfig Section(const std::string& section) const;
+
+        const std::map<std::string, std::string>& GetData() const
         {
             return _data_;
         }
 
     private:
+        // _data_ԤȽֵ
+        void BuildValues();
 
         config_data_t _data_;
+        config_value_t _values_;
+    };
+
+    /* ü󶨵ṹSΪTĳԱ */
+    template<typename S, typename T>
+    class ConfigKey
+    {
+    public:
+        ConfigKey(const StringView& key, T S::*member, bool required)
+            : _key_(key), _member_(member), _required_(required) {}
+
+        // ʱԱԭֵļʱfalse
+        bool Bind(const SimpleConfig& config, S& target) const
+        {
+            const ConfigValue* value = config.Find(_key_);
+            if (value == NULL)
+            {
+                return !_required_;
+            }
+            target.*_member_ = value->as<T>();
+            return true;
+        }
+
+    private:
+        StringView _key_;
+        T S::*_member_;
+        bool _required_;
+    };
+
+    template<typename S, typename T>
+    ConfigKey<S, T> MakeConfigKey(const char* key, T S::*member, bool required = false)
+    {
+        return ConfigKey<S, T>(key, member, required);
+    }
+
+    /* һ԰󶨵ṹĸԱֱ֮ӶȡԱٰң
+     *     struct TileConfig { int level; std::string format; };
+     *     TileConfig tile = { 10, "png" };
+     *     BindConfig(config.Section("tile"), tile,
+     *         MakeConfigKey("level", &TileConfig::level, true),
+     *         MakeConfigKey("format", &TileConfig::format));
+     * бļʱtrue */
+    template<typename S>
+    bool BindConfig(const SimpleConfig& config, S& target)
+    {
+        return true;
+    }
+
+    template<typename S, typename Key, typename... Keys>
+    bool BindConfig(const SimpleConfig& config, S& target, const Key& key, const Keys&... keys)
+    {
+        bool ok = key.Bind(config, target);
+        return BindConfig(config, target, keys...) && ok;
+    }
+
+    /* ȼصą̼̃߳ļ(Linuxʹinotify)ļ仯ʱµã
+     * Ϊֻ巢ȡֻ߲һԭӼһԭӶȡῴһ
+     * ɵĿڷ֮ǰʼĶȡȫ֮(ֻSRCU)Ƶ¼زۻڴ */
+    class ReloadableConfig
+    {
+    public:
+        /* ȡ߳еĿգڼһֱЧʱӦ̣
+         * ڼ䷢ĿնҪͷܻ֮ */
+        class SnapshotPtr
+        {
+        public:
+            SnapshotPtr() : _owner_(NULL), _config_(NULL), _slot_(0) {}
+            SnapshotPtr(const SnapshotPtr& other)
+                : _owner_(other._owner_), _config_(other._config_), _slot_(other._slot_)
+            {
+                // ԭĳ߻ûͷţڴڼ
+                if (_owner_ != NULL)
+                {
+                    _owner_->_readers_[_slot_].fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            SnapshotPtr(SnapshotPtr&& other)
+                : _owner_(other._owner_), _config_(other._config_), _slot_(other._slot_)
+            {
+                other._owner_ = NULL;
+                other._config_ = NULL;
+            }
+            SnapshotPtr& operator=(SnapshotPtr other)
+            {
+                std::swap(_owner_, other._owner_);
+                std::swap(_config_, other._config_);
+                std::swap(_slot_, other._slot_);
+                return *this;
+            }
+            ~SnapshotPtr()
+            {
+                reset();
+            }
+
+            void reset()
+            {
+                if (_owner_ != NULL)
+                {
+                    _owner_->_readers_[_slot_].fetch_sub(1, std::memory_order_release);
+                    _owner_ = NULL;
+                }
+                _config_ = NULL;
+            }
+
+            const SimpleConfig* get() const { return _config_; }
+            const SimpleConfig& operator*() const { return *_config_; }
+            const SimpleConfig* operator->() const { return _config_; }
+            explicit operator bool() const { return _config_ != NULL; }
+
+        private:
+            friend class ReloadableConfig;
+
+            const ReloadableConfig* _owner_;
+            const SimpleConfig* _config_;
+            size_t _slot_;
+        };
+
+        ReloadableConfig() : _current_(NULL), _epoch_(0), _version_(0), _phase_(0),
+            _watcher_(NULL), _stopped_(false)
+        {
+            _readers_[0].store(0);
+            _readers_[1].store(0);
+        }
+        ~ReloadableConfig();
+
+        // ļʼӣ״μʧʱfalse
+        bool Start(const std::string& filename);
+        // ֹͣӣѾĿȻԶȡ
+        void Stop();
+        // ¼һΣʧʱԭĿգȴȡߣɿ֮
+        bool Reload();
+
+        // ǰգStartɹ֮ǰΪ
+        // ȵһδȡһοգ֮Ķȡʹһ
+        SnapshotPtr Snapshot() const
+        {
+            SnapshotPtr snapshot;
+            snapshot._slot_ = _epoch_.load(std::memory_order_relaxed) & 1;
+            _readers_[snapshot._slot_].fetch_add(1, std::memory_order_seq_cst);
+            // ȡָ붼seq_cstȫУ߿Ϊ0ʱ֮Ķȡһµָ
+            // x86ARMv8seq_cstĶȡacquireȡͬһָ
+            snapshot._config_ = _current_.load(std::memory_order_seq_cst);
+            snapshot._owner_ = this;
+            return snapshot;
+        }
+        // ÿһ¿ռ1
+        size_t Version() const
+        {
+            return _version_.load(std::memory_order_acquire);
+        }
+        // Ѿ滻ڵȴȡ߽ľɿ
+        size_t PendingSnapshots() const;
+
+    private:
+        ReloadableConfig(const ReloadableConfig&);
+        ReloadableConfig& operator=(const ReloadableConfig&);
+
+        void WatchWorker();
+        // ƽգȴȡߣҪ_reload_lock_غдյĿʱtrue
+        bool TryReclaim();
+
+        std::string _filename_;
+        std::atomic<const SimpleConfig*> _current_;
+        // ȡ߰_epoch_żѡ
+        std::atomic<size_t> _epoch_;
+        mutable std::atomic<size_t> _readers_[2];
+        std::atomic<size_t> _version_;
+        // ³Ա_reload_lock_ȡ߲ʹ
+        mutable std::mutex _reload_lock_;
+        // δʼյľɿգԼڵȴιľɿ
+        std::vector<const SimpleConfig*> _retired_;
+        std::vector<const SimpleConfig*> _draining_;
+        // 0У1ȴһлǰļ۹㣬2ȴڶлǰļ۹
+        int _phase_;
+        std::thread* _watcher_;
+        std::atomic<bool> _stopped_;
+        // ڻѼ̵߳Ĺܵ
+        int _wake_pipe_[2];
     };
 }
 
@@ -5,10 +5,12 @@
 #include <memory.h>
 
 #include <iostream>
+#include <algorithm>
 #include <cmath>
 #include <exception>
 #include <mutex>
 #include <map>
+#include <memory>
 #include <future>
 
 namespace image_helper {
@@ -49,7 +51,8 @@ int getGridCoord(const int scaleLevel, const double coordX,
     return 0;
 }
 
-std::map<std::string, FREE_IMAGE_FORMAT> formatMap = {
+// 键指向字符串常量，按忽略大小写的顺序比较，查找时无需复制或转换后缀
+std::map<htk::StringView, FREE_IMAGE_FORMAT, htk::ILess> formatMap = {
         {"bmp", FIF_BMP}, {"cut", FIF_CUT}, {"dds", FIF_DDS}, {"gif", FIF_GIF},
         {"hdr", FIF_HDR}, {"ico", FIF_ICO}, {"iff", FIF_IFF}, {"lbm", FIF_IFF},
         {"jng", FIF_JNG}, {"jpg", FIF_JPEG}, {"jif", FIF_JPEG},
@@ -68,7 +71,8 @@ FREE_IMAGE_FORMAT getImageFormat(const std::string& imagePath) {
     if (dotIndex == std::string::npos || dotIndex == imagePath.size() - 1) {
         return FIF_UNKNOWN;
     }
-    std::string suffix = htk::toLower(imagePath.substr(dotIndex + 1));
+    htk::StringView suffix(imagePath.data() + dotIndex + 1,
+            imagePath.size() - dotIndex - 1);
     auto mapIter = formatMap.find(suffix);
     if (mapIter != formatMap.end()) {
         return mapIter->second;
@@ -176,6 +180,33 @@ int TileImages::setThreadNumber(const int threadNum) {
     return 0;
 }
 
+int TileImages::setShard(const int shardIndex, const int shardCount) {
+    CHECK_ARGS(shardCount > 0 && shardIndex >= 0 && shardIndex < shardCount,
+            "Illegal shard %d of %d.", shardIndex, shardCount);
+    shardIndex_ = shardIndex;
+    shardCount_ = shardCount;
+    return 0;
+}
+
+int TileImages::setGridRange(const int gridX0, const int gridY0,
+        const int gridX1, const int gridY1) {
+    CHECK_ARGS(gridX1 >= gridX0 && gridY1 <= gridY0,
+            "Illegal grid range (%d, %d)->(%d, %d).",
+            gridX0, gridY0, gridX1, gridY1);
+    hasGridRange_ = true;
+    rangeX0_ = gridX0;
+    rangeY0_ = gridY0;
+    rangeX1_ = gridX1;
+    rangeY1_ = gridY1;
+    return 0;
+}
+
+int TileImages::setParentProgress(
+        program_helper::Progress* parentProgress) {
+    parentProgress_ = parentProgress;
+    return 0;
+}
+
 int TileImages::setSamplingFilter(const FREE_IMAGE_FILTER upSamplingFilter,
         const FREE_IMAGE_FILTER downSamplingFilter) {
     upSamplingFilter_ = upSamplingFilter;
@@ -184,6 +215,7 @@ int TileImages::setSamplingFilter(const FREE_IMAGE_FILTER upSamplingFilter,
 }
 
 int TileImages::tiling() {
+    TRACE_SCOPE("tiling");
     CHECK_ARGS(images_.empty(), "Src image is already tiled.");
     CHECK_ARGS(access(srcImagePath_.c_str(), R_OK) >= 0,
             "Src image \"%s\" not exist or not readable.",
@@ -193,6 +225,13 @@ int TileImages::tiling() {
                 "Illegal coord for src image: ", x0_, y0_, x1_, y1_);
     CHECK_ARGS(scaleLevel_ > -1, "Scale level not set for src image.");
 
+    // 计算当前需要处理的网格范围，分片为空时不需要打开源图片
+    CHECK_RET(calcTileRange(), "Failed to calculate tile range.");
+    if (emptyRange_) {
+        std::cout << ">> No tile rows in shard " << shardIndex_ << "/" <<
+                shardCount_ << ", skip tiling.\n";
+        return 0;
+    }
     FIBITMAP* srcImage = nullptr;
     // 打开源图片
     std::cout << ">> Opening src image...\n";
@@ -232,10 +271,10 @@ int TileImages::tiling() {
 int TileImages::getTile(FIBITMAP** tileImage, const int gridX,
         const int gridY) {
     CHECK_ARGS(!images_.empty(), "Please get tile image after tiling.");
-    CHECK_ARGS(gridX >= gridX0_ &&  gridX <= gridX1_ && gridY >= gridY0_ &&
-            gridY <= gridY1_, "Grid coord (%d, %d) %s (%d, %d)->(%d, %d)",
-            "out of bound", gridX, gridY, gridX0_, gridY0_, gridX1_, gridY1_);
-    *tileImage = images_[gridY - gridY0_][gridX - gridX0_];
+    CHECK_ARGS(gridX >= tileX0_ &&  gridX <= tileX1_ && gridY <= tileY0_ &&
+            gridY >= tileY1_, "Grid coord (%d, %d) %s (%d, %d)->(%d, %d)",
+            "out of bound", gridX, gridY, tileX0_, tileY0_, tileX1_, tileY1_);
+    *tileImage = images_[tileY0_ - gridY][gridX - tileX0_];
     return 0;
 }
 
@@ -266,32 +305,39 @@ int TileImages::getTileWithLatLon(FIBITMAP** tileImage, const double coordX,
 
 int TileImages::saveAllTiles(std::function<std::string(const int,
         const int)> pathGenerator) {
+    TRACE_SCOPE("saveAllTiles");
+    if (emptyRange_) {
+        std::cout << ">> No tile rows in shard " << shardIndex_ << "/" <<
+                shardCount_ << ", skip saving.\n";
+        return 0;
+    }
     CHECK_ARGS(!images_.empty(), "Please save tile image after tiling.");
-    int gridWidth = gridX1_ - gridX0_;
-    int gridHeight = gridY0_ - gridY1_;
+    int gridWidth = tileX1_ - tileX0_;
+    int gridHeight = tileY0_ - tileY1_;
     int totalCnt = (gridWidth + 1) * (gridHeight + 1);
-    for (int gridY = gridY0_; gridY >= gridY1_; gridY--) {
-        for (int gridX = gridX0_; gridX <= gridX1_; gridX++) {
+    for (int gridY = tileY0_; gridY >= tileY1_; gridY--) {
+        for (int gridX = tileX0_; gridX <= tileX1_; gridX++) {
             saveWorkList_.push_back(SaveWork {
-                    images_[gridY0_ - gridY][gridX - gridX0_], gridX, gridY});
+                    images_[tileY0_ - gridY][gridX - tileX0_], gridX, gridY});
         }
     }
     int workPerThread = static_cast<double>(totalCnt) / threadNum_;
     int startIndex = 0;
     std::vector<std::thread*> threadList;
     std::vector<int> threadStatus(threadNum_, -1);
-    program_helper::Progress progressBar(totalCnt);
+    std::unique_ptr<program_helper::Progress> progressBar(
+            createProgress("save", totalCnt));
     std::cout << ">> Start saving all the tile images.\n";
     for (int i = 0; i < threadNum_; i++) {
         if (i != threadNum_ - 1) {
             threadList.push_back(new std::thread(savingWorker, startIndex,
-                    workPerThread, saveWorkList_, gridX0_, gridY0_,
-                    pathGenerator, &progressBar, &threadStatus[i]));
+                    workPerThread, saveWorkList_, tileX0_, tileY0_,
+                    pathGenerator, progressBar.get(), &threadStatus[i]));
             startIndex += workPerThread;
         } else {
             threadList.push_back(new std::thread(savingWorker, startIndex,
-                    totalCnt - startIndex, saveWorkList_, gridX0_, gridY0_,
-                    pathGenerator, &progressBar, &threadStatus[i]));
+                    totalCnt - startIndex, saveWorkList_, tileX0_, tileY0_,
+                    pathGenerator, progressBar.get(), &threadStatus[i]));
         }
     }
     for (int i = 0; i < threadNum_; i++) {
@@ -310,6 +356,7 @@ void TileImages::savingWorker(const int startIndex, const int workCnt,
         std::function<std::string(const int, const int)> pathGenerator,
         program_helper::Progress* progressBar, int* result) {
     const int endIndex = startIndex + workCnt;
+    program_helper::ProgressBatch progress(progressBar);
     std::string savePath;
     for (int i = startIndex; i < endIndex; i++) {
         const SaveWork& work = workList[i];
@@ -324,13 +371,19 @@ void TileImages::savingWorker(const int startIndex, const int workCnt,
                     savePath << "\".\n";
             return;
         }
-        if (!FreeImage_Save(outputFormat, work.tileImage,
-                savePath.c_str(), 0)) {
+        bool saved = false;
+        {
+            TRACE_SCOPE("encodeTile");
+            saved = FreeImage_Save(outputFormat, work.tileImage,
+                    savePath.c_str(), 0);
+        }
+        if (!saved) {
             std::cerr << "Error: Failed to save image in coord (" <<
                     work.gridX << ", " << work.gridY << ").\n";
             return;
         }
-        progressBar->addProgress(1);
+        progress.addProgress(1);
+        TRACE_COUNTER("savedTiles", 1);
     }
     *result = 0;
     return;
@@ -341,14 +394,14 @@ int TileImages::saveTile(const std::string& savePath, const int gridX,
     std::cout << "-- Save tile image in grid (" << gridX << ", " << gridY <<
             ") to path \"" << savePath << "\"."<< std::endl;
     CHECK_ARGS(!images_.empty(), "Please save tile image after tiling.");
-    CHECK_ARGS(gridX >= gridX0_ &&  gridX <= gridX1_ && gridY <= gridY0_ &&
-            gridY >= gridY1_, "Grid coord (%d, %d) %s (%d, %d)->(%d, %d)",
-            "out of bound", gridX, gridY, gridX0_, gridY0_, gridX1_, gridY1_);
+    CHECK_ARGS(gridX >= tileX0_ &&  gridX <= tileX1_ && gridY <= tileY0_ &&
+            gridY >= tileY1_, "Grid coord (%d, %d) %s (%d, %d)->(%d, %d)",
+            "out of bound", gridX, gridY, tileX0_, tileY0_, tileX1_, tileY1_);
     FREE_IMAGE_FORMAT outputFormat = getImageFormat(savePath);
     CHECK_ARGS(outputFormat != FIF_UNKNOWN,
             "Unknown output format in path \"%s\".", savePath.c_str());
     CHECK_ARGS(FreeImage_Save(outputFormat,
-            images_[gridY0_ - gridY][gridX - gridX0_], savePath.c_str(), 0),
+            images_[tileY0_ - gridY][gridX - tileX0_], savePath.c_str(), 0),
             "Failed to save image in coord (%d, %d).", gridX, gridY);
     return 0;
 }
@@ -378,7 +431,16 @@ int TileImages::saveTileWithLatLon(const std::string& savePath,
     return 0;
 }
 
+program_helper::Progress* TileImages::createProgress(
+        const std::string& name, const int totalCount) {
+    if (parentProgress_) {
+        return new program_helper::Progress(parentProgress_, name, totalCount);
+    }
+    return new program_helper::Progress(totalCount);
+}
+
 int TileImages::openSrcImage(FIBITMAP** srcImage) {
+    TRACE_SCOPE("openSrcImage");
     srcImageFormat_ = getImageFormat(srcImagePath_);
     CHECK_ARGS(srcImageFormat_ != FIF_UNKNOWN, "Unknown format of src image.");
     *srcImage = FreeImage_Load(srcImageFormat_, srcImagePath_.c_str());
@@ -386,18 +448,52 @@ int TileImages::openSrcImage(FIBITMAP** srcImage) {
     return 0;
 }
 
-int TileImages::scaleSrcImage(FIBITMAP** srcImage) {
+int TileImages::calcTileRange() {
     CHECK_RET(getGridCoord(scaleLevel_, x0_, y0_, &gridX0_, &gridY0_),
             "Failed to get grid coord for mc coord (%f, %f).", x0_, y0_);
     CHECK_RET(getGridCoord(scaleLevel_, x1_, y1_, &gridX1_, &gridY1_),
             "Failed to get grid coord for mc coord (%f, %f).", x1_, y1_);
     CHECK_ARGS(gridX1_ >= gridX0_ && gridY1_ <= gridY0_,
-            "Error: Calculated grid coord (%d, %d)->(%d, %d) is illegal.");
-    
+            "Error: Calculated grid coord (%d, %d)->(%d, %d) is illegal.",
+            gridX0_, gridY0_, gridX1_, gridY1_);
+
     gridPixelWidth_ = (gridX1_ - gridX0_ + 1) * tileWidth_;
     gridPixelHeight_ = (gridY0_ - gridY1_ + 1) * tileHeight_;
     mercator2Pixel(scaleLevel_, x0_, y0_, &pixelX0_, &pixelY0_);
     mercator2Pixel(scaleLevel_, x1_, y1_, &pixelX1_, &pixelY1_);
+
+    tileX0_ = gridX0_;
+    tileY0_ = gridY0_;
+    tileX1_ = gridX1_;
+    tileY1_ = gridY1_;
+    if (hasGridRange_) {
+        tileX0_ = std::max(tileX0_, rangeX0_);
+        tileY0_ = std::min(tileY0_, rangeY0_);
+        tileX1_ = std::min(tileX1_, rangeX1_);
+        tileY1_ = std::max(tileY1_, rangeY1_);
+        CHECK_ARGS(tileX1_ >= tileX0_ && tileY1_ <= tileY0_,
+                "Grid range (%d, %d)->(%d, %d) %s (%d, %d)->(%d, %d).",
+                rangeX0_, rangeY0_, rangeX1_, rangeY1_, "is out of src grid",
+                gridX0_, gridY0_, gridX1_, gridY1_);
+    }
+    // 按瓦片行划分分片，保证同一分片内解码和裁剪的数据在行方向连续
+    int64_t rowCnt = tileY0_ - tileY1_ + 1;
+    int rowBegin = rowCnt * shardIndex_ / shardCount_;
+    int rowEnd = rowCnt * (shardIndex_ + 1) / shardCount_;
+    emptyRange_ = rowBegin == rowEnd;
+    tileY1_ = tileY0_ - rowEnd + 1;
+    tileY0_ = tileY0_ - rowBegin;
+    if (shardCount_ > 1 || hasGridRange_) {
+        std::cout << "-- Process tile range (" << tileX0_ << ", " <<
+                tileY0_ << ")->(" << tileX1_ << ", " << tileY1_ <<
+                ") in shard " << shardIndex_ << "/" << shardCount_ <<
+                std::endl;
+    }
+    return 0;
+}
+
+int TileImages::scaleSrcImage(FIBITMAP** srcImage) {
+    TRACE_SCOPE("scaleSrcImage");
     unsigned imagePixelWidth = pixelX1_ - pixelX0_;
     unsigned imagePixelHeight = pixelY0_ - pixelY1_;
   
@@ -423,17 +519,51 @@ int TileImages::scaleSrcImage(FIBITMAP** srcImage) {
 } 
 
 int TileImages::fillSrcImage(FIBITMAP** srcImage) {
+    TRACE_SCOPE("fillSrcImage");
     FIBITMAP* newSrcImage = nullptr;
+    // 当前处理范围在完整网格图片中的像素位置
+    const int rangePixelX = (tileX0_ - gridX0_) * tileWidth_;
+    const int rangePixelY = (gridY0_ - tileY0_) * tileHeight_;
+    const int rangePixelWidth = (tileX1_ - tileX0_ + 1) * tileWidth_;
+    const int rangePixelHeight = (tileY0_ - tileY1_ + 1) * tileHeight_;
+    // 缩放后的图片在完整网格图片中的位置
+    const int imagePixelX = pixelX0_ & 0xFF;
+    const int imagePixelY = 256 - (pixelY0_ & 0xFF);
+    // 只保留缩放后图片落在当前处理范围内的部分
+    const int left = std::max(rangePixelX, imagePixelX);
+    const int top = std::max(rangePixelY, imagePixelY);
+    const int right = std::min(rangePixelX + rangePixelWidth, imagePixelX +
+            static_cast<int>(FreeImage_GetWidth(*srcImage)));
+    const int bottom = std::min(rangePixelY + rangePixelHeight, imagePixelY +
+            static_cast<int>(FreeImage_GetHeight(*srcImage)));
     // 填充缩放后的图片
-    std::cout << "-- Fill src image to "<< gridPixelWidth_ << "*" <<
-            gridPixelHeight_ << std::endl;
-    newSrcImage = FreeImage_Allocate(gridPixelWidth_, gridPixelHeight_, 32);
+    std::cout << "-- Fill src image to "<< rangePixelWidth << "*" <<
+            rangePixelHeight << std::endl;
+    newSrcImage = FreeImage_Allocate(rangePixelWidth, rangePixelHeight, 32);
     CHECK_ARGS(newSrcImage != NULL, "Failed to create background image.");
-    if (!FreeImage_Paste(newSrcImage, *srcImage, pixelX0_ & 0xFF,
-            256 - (pixelY0_ & 0xFF), 256)) {
-        FreeImage_Unload(newSrcImage);
-        CHECK_ARGS(false, "Failed to fill src image with empty background.");
-        return 0;
+    if (right > left && bottom > top) {
+        FIBITMAP* rangeImage = *srcImage;
+        if (right - left != static_cast<int>(FreeImage_GetWidth(*srcImage)) ||
+                bottom - top !=
+                static_cast<int>(FreeImage_GetHeight(*srcImage))) {
+            rangeImage = FreeImage_Copy(*srcImage, left - imagePixelX,
+                    top - imagePixelY, right - imagePixelX,
+                    bottom - imagePixelY);
+            if (rangeImage == NULL) {
+                FreeImage_Unload(newSrcImage);
+                CHECK_ARGS(false, "Failed to crop src image to tile range.");
+            }
+        }
+        BOOL pasted = FreeImage_Paste(newSrcImage, rangeImage,
+                left - rangePixelX, top - rangePixelY, 256);
+        if (rangeImage != *srcImage) {
+            FreeImage_Unload(rangeImage);
+        }
+        if (!pasted) {
+            FreeImage_Unload(newSrcImage);
+            CHECK_ARGS(false,
+                    "Failed to fill src image with empty background.");
+        }
     }
     FreeImage_Unload(*srcImage);
     *srcImage = newSrcImage;
@@ -441,8 +571,9 @@ int TileImages::fillSrcImage(FIBITMAP** srcImage) {
 }
 
 int TileImages::cutSrcImage(FIBITMAP** srcImage) {
-    int gridWidth = gridX1_ - gridX0_;
-    int gridHeight = gridY0_ - gridY1_;
+    TRACE_SCOPE("cutSrcImage");
+    int gridWidth = tileX1_ - tileX0_;
+    int gridHeight = tileY0_ - tileY1_;
     int totalCnt = (gridWidth + 1) * (gridHeight + 1);
     std::cout << "-- Cut src image into " << totalCnt << " tiles\n";
     int gridx = 0;
@@ -463,23 +594,26 @@ int TileImages::cutSrcImage(FIBITMAP** srcImage) {
         threadNum_ = threadCnt * 10;
         threadNum_ = threadNum_ % 10 > 5 ? threadNum_ / 10 + 1 :
                 threadNum_ / 10;
+        // 分片后的瓦片数目可能很少，至少保留一个线程
+        threadNum_ = std::max(threadNum_, 1);
     } else {
         workPerThread = totalCnt / threadNum_;
     }
     int startIndex = 0;
     std::vector<std::thread*> threadList;
     std::vector<int> threadStatus(threadNum_, -1);
-    program_helper::Progress progressBar(totalCnt);
+    std::unique_ptr<program_helper::Progress> progressBar(
+            createProgress("cut", totalCnt));
     for (int i = 0; i < threadNum_; i++) {
         if (i != threadNum_ - 1) {
             threadList.push_back(new std::thread(tilingWorker, startIndex,
                     workPerThread, tileWorkList_, *srcImage, tileWidth_,
-                    tileHeight_, &progressBar, &threadStatus[i]));
+                    tileHeight_, progressBar.get(), &threadStatus[i]));
             startIndex += workPerThread;
         } else {
             threadList.push_back(new std::thread(tilingWorker, startIndex,
                     totalCnt - startIndex, tileWorkList_, *srcImage, tileWidth_,
-                    tileHeight_, &progressBar, &threadStatus[i]));
+                    tileHeight_, progressBar.get(), &threadStatus[i]));
         }
     }
     for (int i = 0; i < threadNum_; i++) {
@@ -497,18 +631,23 @@ void TileImages::tilingWorker(const int startIndex, const int workCount,
         const int tileWidth, const int tileHeight,
         program_helper::Progress* progressBar, int* result) {
     const int endIndex = startIndex + workCount;
+    program_helper::ProgressBatch progress(progressBar);
     for (int i = startIndex; i < endIndex; i++) {
         const TileWork& work = workList[i];
-        *(work.tileImage) = FreeImage_Copy(srcImage, work.pixelX0,
-                work.pixelY0, work.pixelX0 + tileWidth,
-                work.pixelY0 + tileHeight);
+        {
+            TRACE_SCOPE("cutTile");
+            *(work.tileImage) = FreeImage_Copy(srcImage, work.pixelX0,
+                    work.pixelY0, work.pixelX0 + tileWidth,
+                    work.pixelY0 + tileHeight);
+        }
         if (*(work.tileImage) == NULL) {
             std::cout << "Error: Failed cut tile image (PixelCoord: " <<
                     work.pixelX0 << ", " << work.pixelY0 <<
                     ") from src image." << std::endl;
             return;
         }
-        progressBar->addProgress(1);
+        progress.addProgress(1);
+        TRACE_COUNTER("cutTiles", 1);
     }
     *result = 0;
     return;
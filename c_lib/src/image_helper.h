@@ -45,6 +45,16 @@ public:
     int setTileSize(const int width, const int height);
     // 设置执行的线程数目(可以使用默认值)
     int setThreadNumber(const int threadNum);
+    // 设置分片编号与分片总数，按瓦片行均匀划分网格(可以使用默认值)
+    // 多个进程使用相同参数和不同分片编号，合起来的输出与单次完整切图一致
+    int setShard(const int shardIndex, const int shardCount);
+    // 设置只处理的网格矩形(左上角和右下角的网格编号)(可以使用默认值)
+    // 与分片同时设置时，分片在该矩形的行范围内进行划分
+    int setGridRange(const int gridX0, const int gridY0, const int gridX1,
+            const int gridY1);
+    // 设置进度显示的父进度，切图和保存会作为它的子进度显示(可以使用默认值)
+    // 用于多个任务同时执行时统一显示进度，父进度需要比当前对象存活更久
+    int setParentProgress(program_helper::Progress* parentProgress);
     
     // 设置图片缩放使用的采样过滤器(可以使用默认值)
     // 可选过滤器如下
@@ -90,6 +100,8 @@ private:
     int fillSrcImage(FIBITMAP** srcImage);
     // 执行多线程的图片裁剪工作
     int cutSrcImage(FIBITMAP** srcImage);
+    // 根据分片设置和网格矩形计算当前需要处理的网格范围
+    int calcTileRange();
 
 private:
     // 多线程执行的任务信息
@@ -121,8 +133,14 @@ private:
             std::function<std::string(const int, const int)> pathGenerator,
             program_helper::Progress* progressBar, int* result);
     
+    // 创建当前阶段使用的进度条(设置了父进度时作为子进度)
+    program_helper::Progress* createProgress(const std::string& name,
+            const int totalCount);
+
     // 执行使用的线程数目
     int threadNum_ = -1;
+    // 进度显示的父进度
+    program_helper::Progress* parentProgress_ = nullptr;
     // 进行图片缩放使用的过滤器类型
     FREE_IMAGE_FILTER upSamplingFilter_ = FILTER_BSPLINE;
     FREE_IMAGE_FILTER downSamplingFilter_ = FILTER_BOX;
@@ -147,6 +165,14 @@ private:
     double y1_ = -1;
     // 当前的比例尺等级
     int scaleLevel_ = -1;
+    // 当前的分片编号与分片总数
+    int shardIndex_ = 0;
+    int shardCount_ = 1;
+    // 指定的网格矩形范围(左上角和右下角的网格编号)
+    bool hasGridRange_ = false;
+    int rangeX0_, rangeY0_, rangeX1_, rangeY1_;
+    // 当前分片是否没有需要处理的瓦片
+    bool emptyRange_ = false;
 
     // 原图片最左上角和右下角图片的像素编号
     int pixelX0_, pixelY0_, pixelX1_, pixelY1_;
@@ -154,7 +180,9 @@ private:
     int gridX0_, gridY0_, gridX1_, gridY1_;
     // 源图片所在网格边界框的像素高宽
     int gridPixelWidth_, gridPixelHeight_;
-    // 所有分割后图片的存储实体
+    // 当前实际处理的左上角和右下角的网格编号(分片或网格矩形之后)
+    int tileX0_, tileY0_, tileX1_, tileY1_;
+    // 所有分割后图片的存储实体(只包含实际处理的网格范围)
     std::vector<std::vector<FIBITMAP*>> images_;
 };
 
@@ -13,6 +13,9 @@
 #include <set>
 #include <cmath>
 #include <cstdlib>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
 
 namespace program_helper {
 
@@ -28,58 +31,557 @@ int getTerminalSize(winsize* terminalSize) {
     return 0;
 }
 
+typedef std::chrono::steady_clock ProgressClock;
+
+struct ProgressNode {
+    ProgressNode(const std::string& nodeName, const int nodeTotalCount,
+            const double nodeWeight) : name(nodeName),
+            totalCount(nodeTotalCount), weight(nodeWeight), count(0),
+            firstChild(nullptr), nextSibling(nullptr),
+            startTime(ProgressClock::now()), sampleTime(startTime),
+            logTime(startTime) {}
+    ~ProgressNode() {
+        ProgressNode* child = firstChild.load(std::memory_order_acquire);
+        while (child) {
+            ProgressNode* nextChild =
+                    child->nextSibling.load(std::memory_order_acquire);
+            delete child;
+            child = nextChild;
+        }
+    }
+
+    // 节点的名字、总进度数值以及在父节点中的权重
+    const std::string name;
+    const int totalCount;
+    const double weight;
+    // 节点自身的进度数值
+    std::atomic<int> count;
+    // 第一个子节点和下一个兄弟节点，节点只会追加不会删除
+    std::atomic<ProgressNode*> firstChild;
+    std::atomic<ProgressNode*> nextSibling;
+    // 节点创建的时间
+    const ProgressClock::time_point startTime;
+
+    // 以下成员只在根进度的显示线程中访问
+    // 最近一次统计的信息以及在进度树中的深度
+    ProgressInfo info = ProgressInfo();
+    int depth = 0;
+    // 按权重折算之后的完成数值和总数值
+    double done = 0;
+    double total = 0;
+    // 上一次统计的完成数值和时间
+    double lastDone = 0;
+    ProgressClock::time_point sampleTime;
+    // 上一次输出日志的完成数值和时间
+    double loggedDone = -1;
+    ProgressClock::time_point logTime;
+};
+
 const char Progress::emptyBarUnit = '-';
 const char Progress::fullBarUnit = '#';
 const int Progress::maxLength = 160;
+const int Progress::nameLength = 24;
+const int Progress::refreshInterval = 100;
+const int Progress::logInterval = 5000;
+const double Progress::rateSmoothing = 3;
 
-Progress::Progress(const int totalCount) : totalCount_(totalCount) {
-    struct winsize terminalSize;
-    // 获取当前的终端大小并设定进度条长度
-    if (getTerminalSize(&terminalSize) >= 0) {
-        barLength_ = std::min(maxLength,
-                static_cast<int>(terminalSize.ws_col));
-        barLength_ = barLength_ - 14 -
-                (std::to_string(totalCount).length() << 1);
-    } else {
-        barLength_ = (maxLength >> 1) - 14 -
-                (std::to_string(totalCount).length() << 1);
+// 将秒数格式化为时:分:秒，未知时显示为横线
+void formatDuration(const double seconds, char* buffer, const size_t size) {
+    if (seconds < 0) {
+        snprintf(buffer, size, "--:--:--");
+        return;
+    }
+    long long totalSeconds = static_cast<long long>(seconds + 0.5);
+    snprintf(buffer, size, "%02lld:%02lld:%02lld", totalSeconds / 3600,
+            totalSeconds / 60 % 60, totalSeconds % 60);
+}
+
+// 按深度优先的顺序收集进度树中的所有节点
+void collectNodes(ProgressNode* node, std::vector<ProgressNode*>* nodes) {
+    nodes->push_back(node);
+    for (ProgressNode* child = node->firstChild.load(std::memory_order_acquire);
+            child; child = child->nextSibling.load(std::memory_order_acquire)) {
+        collectNodes(child, nodes);
+    }
+}
+
+Progress::Progress(const int totalCount) :
+        Progress("", totalCount, AUTO_OUTPUT) {}
+
+Progress::Progress(const int totalCount, const OutputMode outputMode,
+        ProgressCallback callback) :
+        Progress("", totalCount, outputMode, callback) {}
+
+Progress::Progress(const std::string& name, const int totalCount,
+        const OutputMode outputMode, ProgressCallback callback) :
+        node_(new ProgressNode(name, totalCount, 1)), isRoot_(true),
+        outputMode_(outputMode), callback_(callback) {
+    // 非终端环境下输出结构化日志，避免在日志中写入大量刷新的进度条
+    if (outputMode_ == AUTO_OUTPUT) {
+        outputMode_ = isatty(STDOUT_FILENO) ? BAR_OUTPUT : LOG_OUTPUT;
+    }
+    if (outputMode_ == BAR_OUTPUT) {
+        struct winsize terminalSize;
+        // 获取当前的终端大小并设定进度条长度(预留剩余时间的显示宽度)
+        if (getTerminalSize(&terminalSize) >= 0) {
+            barLength_ = std::min(maxLength,
+                    static_cast<int>(terminalSize.ws_col));
+            barLength_ = barLength_ - 28 -
+                    (std::to_string(totalCount).length() << 1);
+        } else {
+            barLength_ = (maxLength >> 1) - 28 -
+                    (std::to_string(totalCount).length() << 1);
+        }
+        barLength_ = barLength_ < 10 ? 10 : barLength_;
+        progressBar_ = new char[barLength_ + 1];
+        for (int i = 0; i < barLength_; i++) {
+            progressBar_[i] = emptyBarUnit;
+        }
+        progressBar_[barLength_] = 0;
     }
-    barLength_ = barLength_ < 10 ? 10 : barLength_;
-    progressBar_ = new char[barLength_ + 1];
-    for (int i = 0; i < barLength_; i++) {
-        progressBar_[i] = emptyBarUnit;
+    reporter_ = std::thread(&Progress::reportProgress, this);
+}
+
+Progress::Progress(Progress* parent, const std::string& name,
+        const int totalCount, const double weight) :
+        node_(new ProgressNode(name, totalCount, weight)), isRoot_(false) {
+    // 无锁地把新节点追加到父节点的子节点链表末尾
+    std::atomic<ProgressNode*>* slot = &parent->node_->firstChild;
+    ProgressNode* expected = nullptr;
+    while (!slot->compare_exchange_weak(expected, node_,
+            std::memory_order_release, std::memory_order_acquire)) {
+        if (expected != nullptr) {
+            slot = &expected->nextSibling;
+            expected = nullptr;
+        }
     }
-    progressBar_[barLength_] = 0;
 }
 
 Progress::~Progress() {
+    // 子进度的节点由根进度统一释放
+    if (!isRoot_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> reporterGuard(reporterLock_);
+        stopped_ = true;
+    }
+    reporterCond_.notify_one();
+    reporter_.join();
     delete [] progressBar_;
+    delete node_;
 }
 
 void Progress::addProgress(const int newProgress) {
-    std::lock_guard<std::mutex> progressGuard(progressLock_);
-    int newProgressCount = progressCount_ + newProgress;
-    percentage_ = static_cast<double>(newProgressCount * 100) / totalCount_;
-    int oldFilledBarCount = progressCount_ * barLength_ / totalCount_;
-    int newFilledBarCount = newProgressCount * barLength_ / totalCount_;
-    progressCount_ = newProgressCount;
-    if (newFilledBarCount > oldFilledBarCount) {
-        for (int i = oldFilledBarCount; i < newFilledBarCount; i++) {
-            progressBar_[i] = fullBarUnit;
+    node_->count.fetch_add(newProgress, std::memory_order_relaxed);
+}
+
+void Progress::reportProgress() {
+    std::unique_lock<std::mutex> reporterGuard(reporterLock_);
+    bool stopped = false;
+    while (!stopped) {
+        stopped = reporterCond_.wait_for(reporterGuard,
+                std::chrono::milliseconds(refreshInterval),
+                [this] { return stopped_; });
+        bool changed = updateProgress(node_, node_->name, 0, stopped);
+        if (outputMode_ == BAR_OUTPUT && changed) {
+            if (node_->firstChild.load(std::memory_order_acquire)) {
+                dumpTree();
+            } else {
+                dumpProgress(node_->info);
+            }
         }
-        dumpProgress();
+    }
+    // 未完成就结束时换行，避免后续输出接在进度条后面
+    if (lineOpen_) {
+        printf("\n");
     }
 }
 
-void Progress::dumpProgress() {
-    printf("[%s]  %d/%d  %.2f%%", progressBar_, progressCount_, totalCount_,
-            percentage_);
-    if (progressCount_ == totalCount_) {
-        printf("\n");
+bool Progress::updateProgress(ProgressNode* node, const std::string& path,
+        const int depth, const bool final) {
+    ProgressClock::time_point now = ProgressClock::now();
+    int count = node->count.load(std::memory_order_relaxed);
+    // 先统计所有子节点，再按权重折算到当前节点
+    bool changed = false;
+    double childDone = 0;
+    double childWeight = 0;
+    for (ProgressNode* child = node->firstChild.load(std::memory_order_acquire);
+            child; child = child->nextSibling.load(std::memory_order_acquire)) {
+        changed |= updateProgress(child,
+                path.empty() ? child->name : path + "/" + child->name,
+                depth + 1, final);
+        childDone += child->weight * (child->total > 0 ?
+                std::min(child->done / child->total, 1.0) : 1.0);
+        childWeight += child->weight;
+    }
+    node->depth = depth;
+    node->done = count + childDone;
+    node->total = childWeight > 0 ?
+            std::max<double>(node->totalCount, count + childWeight) :
+            node->totalCount;
+
+    // 开始阶段使用平均速度，之后对瞬时速度做指数平滑
+    ProgressInfo& info = node->info;
+    info.elapsed = std::chrono::duration<double>(
+            now - node->startTime).count();
+    double interval = std::chrono::duration<double>(
+            now - node->sampleTime).count();
+    if (info.elapsed < rateSmoothing) {
+        info.rate = info.elapsed > 0 ? node->done / info.elapsed : 0;
+    } else if (interval > 0) {
+        double instantRate = (node->done - node->lastDone) / interval;
+        info.rate += (1 - std::exp(-interval / rateSmoothing)) *
+                (instantRate - info.rate);
+    }
+    node->sampleTime = now;
+    bool nodeChanged = node->done != node->lastDone;
+    node->lastDone = node->done;
+
+    info.name = path;
+    info.count = static_cast<int>(node->done);
+    info.totalCount = static_cast<int>(std::ceil(node->total));
+    info.percentage = node->total > 0 ? node->done * 100 / node->total : 100;
+    bool finished = node->done >= node->total;
+    if (finished) {
+        info.eta = 0;
     } else {
+        info.eta = info.rate > 0 ? (node->total - node->done) / info.rate : -1;
+    }
+
+    if (callback_ && (nodeChanged || final)) {
+        callback_(info);
+    }
+    if (outputMode_ == LOG_OUTPUT && node->loggedDone != node->done &&
+            (finished || final || now - node->logTime >=
+            std::chrono::milliseconds(logInterval))) {
+        node->loggedDone = node->done;
+        node->logTime = now;
+        logProgress(info);
+    }
+    return changed || nodeChanged;
+}
+
+void Progress::dumpProgress(const ProgressInfo& info) {
+    int filledBarCount = info.totalCount <= 0 ? barLength_ :
+            static_cast<int64_t>(std::min(info.count, info.totalCount)) *
+            barLength_ / info.totalCount;
+    for (; barCount_ < filledBarCount; barCount_++) {
+        progressBar_[barCount_] = fullBarUnit;
+    }
+    char eta[32];
+    formatDuration(info.eta, eta, sizeof(eta));
+    printf("[%s]  %d/%d  %.2f%%  ETA %s", progressBar_, info.count,
+            info.totalCount, info.percentage, eta);
+    lineOpen_ = info.count < info.totalCount;
+    if (lineOpen_) {
         printf("\r");
         fflush(stdout);
+    } else {
+        printf("\n");
+    }
+}
+
+void Progress::dumpTree() {
+    std::vector<ProgressNode*> nodes;
+    collectNodes(node_, &nodes);
+    // 回到上一次显示的第一行，整体重绘所有进度
+    if (treeLines_ > 0) {
+        printf("\033[%dA", treeLines_);
+    }
+    const int treeBarLength = std::max(10, barLength_ - nameLength);
+    std::string bar;
+    std::string label;
+    char eta[32];
+    for (ProgressNode* node : nodes) {
+        label.assign(node->depth * 2, ' ');
+        label += node->depth == 0 && node->name.empty() ? "total" : node->name;
+        label.resize(nameLength, ' ');
+        double fraction = node->total > 0 ?
+                std::min(node->done / node->total, 1.0) : 1.0;
+        int filledBarCount = static_cast<int>(fraction * treeBarLength);
+        bar.assign(filledBarCount, fullBarUnit);
+        bar.append(treeBarLength - filledBarCount, emptyBarUnit);
+        formatDuration(node->info.eta, eta, sizeof(eta));
+        printf("\r%s [%s]  %d/%d  %.2f%%  ETA %s\033[K\n", label.c_str(),
+                bar.c_str(), node->info.count, node->info.totalCount,
+                node->info.percentage, eta);
+    }
+    fflush(stdout);
+    treeLines_ = nodes.size();
+    lineOpen_ = false;
+}
+
+void Progress::logProgress(const ProgressInfo& info) {
+    printf("[PROGRESS] ");
+    if (!info.name.empty()) {
+        printf("task=%s ", info.name.c_str());
     }
+    printf("count=%d total=%d percent=%.2f rate=%.2f eta=%.1f "
+            "elapsed=%.1f\n", info.count, info.totalCount, info.percentage,
+            info.rate, info.eta, info.elapsed);
+    fflush(stdout);
+}
+
+// 追踪事件
+struct TraceEvent {
+    // 事件的名字
+    const char* name;
+    // 事件类型，'X'为耗时区间，'C'为计数器
+    char phase;
+    // 事件的开始时间，单位为微秒
+    int64_t timestamp;
+    // 耗时区间的持续时间或者计数器增加的数值
+    int64_t value;
+};
+
+// 按2的幂次分桶的直方图
+struct TraceHistogram {
+    int64_t count = 0;
+    double sum = 0;
+    double min = 0;
+    double max = 0;
+    // 第i个桶统计[2^(i-1), 2^i)范围内的样本，第0个桶统计小于1的样本
+    int64_t buckets[64] = {0};
+};
+
+// 每个线程独占的追踪缓冲区
+struct TraceBuffer {
+    // 只在写入线程和保存数据时竞争，正常记录时没有竞争
+    std::mutex lock;
+    // 缓冲区编号，作为Chrome Trace中的线程编号
+    int tid = 0;
+    // 缓冲区当前是否有线程在使用
+    bool active = true;
+    // 记录的事件以及因为缓冲区已满丢弃的事件数目
+    std::vector<TraceEvent> events;
+    int64_t droppedCount = 0;
+    // 记录的直方图
+    std::map<const char*, TraceHistogram> histograms;
+};
+
+// 单个线程最多记录的事件数目
+const size_t kMaxTraceEvents = 1 << 20;
+
+std::atomic<bool> Trace::enabled_(false);
+
+// 所有线程的追踪缓冲区，线程退出之后缓冲区会留给新线程复用
+std::mutex traceBufferLock;
+std::vector<TraceBuffer*> traceBuffers;
+// 开始记录的时间
+std::atomic<int64_t> traceStartTime(0);
+
+// 线程退出时释放对缓冲区的占用
+struct TraceBufferHolder {
+    ~TraceBufferHolder() {
+        if (buffer) {
+            std::lock_guard<std::mutex> bufferGuard(traceBufferLock);
+            buffer->active = false;
+        }
+    }
+    TraceBuffer* buffer = nullptr;
+};
+
+thread_local TraceBufferHolder traceBufferHolder;
+
+// 获取当前线程的追踪缓冲区
+TraceBuffer* getTraceBuffer() {
+    if (traceBufferHolder.buffer) {
+        return traceBufferHolder.buffer;
+    }
+    std::lock_guard<std::mutex> bufferGuard(traceBufferLock);
+    for (TraceBuffer* buffer : traceBuffers) {
+        if (!buffer->active) {
+            buffer->active = true;
+            traceBufferHolder.buffer = buffer;
+            return buffer;
+        }
+    }
+    TraceBuffer* buffer = new TraceBuffer();
+    buffer->tid = traceBuffers.size() + 1;
+    buffer->events.reserve(1024);
+    traceBuffers.push_back(buffer);
+    traceBufferHolder.buffer = buffer;
+    return buffer;
+}
+
+// 输出JSON字符串，对特殊字符进行转义
+void writeJsonString(FILE* file, const char* str) {
+    fputc('"', file);
+    for (; *str; str++) {
+        unsigned char c = *str;
+        if (c == '"' || c == '\\') {
+            fputc('\\', file);
+            fputc(c, file);
+        } else if (c < 0x20) {
+            fprintf(file, "\\u%04x", c);
+        } else {
+            fputc(c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+void Trace::start() {
+    std::lock_guard<std::mutex> bufferGuard(traceBufferLock);
+    for (TraceBuffer* buffer : traceBuffers) {
+        std::lock_guard<std::mutex> eventGuard(buffer->lock);
+        buffer->events.clear();
+        buffer->droppedCount = 0;
+        buffer->histograms.clear();
+    }
+    traceStartTime.store(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    enabled_.store(true);
+}
+
+void Trace::stop() {
+    enabled_.store(false);
+}
+
+int64_t Trace::now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count() -
+            traceStartTime.load(std::memory_order_relaxed);
+}
+
+void Trace::addSpan(const char* name, const int64_t startTime,
+        const int64_t endTime) {
+    TraceBuffer* buffer = getTraceBuffer();
+    std::lock_guard<std::mutex> eventGuard(buffer->lock);
+    if (buffer->events.size() >= kMaxTraceEvents) {
+        buffer->droppedCount++;
+        return;
+    }
+    buffer->events.push_back(TraceEvent {name, 'X', startTime,
+            endTime - startTime});
+}
+
+void Trace::addCounter(const char* name, const int64_t value) {
+    int64_t timestamp = now();
+    TraceBuffer* buffer = getTraceBuffer();
+    std::lock_guard<std::mutex> eventGuard(buffer->lock);
+    if (buffer->events.size() >= kMaxTraceEvents) {
+        buffer->droppedCount++;
+        return;
+    }
+    buffer->events.push_back(TraceEvent {name, 'C', timestamp, value});
+}
+
+void Trace::addHistogram(const char* name, const double value) {
+    int bucket = 0;
+    if (value >= 1) {
+        bucket = std::min(63, static_cast<int>(std::log2(value)) + 1);
+    }
+    TraceBuffer* buffer = getTraceBuffer();
+    std::lock_guard<std::mutex> eventGuard(buffer->lock);
+    TraceHistogram& histogram = buffer->histograms[name];
+    if (histogram.count == 0 || value < histogram.min) {
+        histogram.min = value;
+    }
+    if (histogram.count == 0 || value > histogram.max) {
+        histogram.max = value;
+    }
+    histogram.count++;
+    histogram.sum += value;
+    histogram.buckets[bucket]++;
+}
+
+int Trace::save(const std::string& filePath) {
+    FILE* file = fopen(filePath.c_str(), "w");
+    CHECK_ARGS(file != NULL, "Failed to open trace file \"%s\".",
+            filePath.c_str());
+    std::lock_guard<std::mutex> bufferGuard(traceBufferLock);
+    // 计数器按时间顺序在所有线程之间累加
+    std::vector<std::pair<int, const TraceEvent*>> counterEvents;
+    std::map<std::string, TraceHistogram> histograms;
+    int64_t droppedCount = 0;
+    bool firstEvent = true;
+    fprintf(file, "{\"traceEvents\":[");
+    for (TraceBuffer* buffer : traceBuffers) {
+        buffer->lock.lock();
+        fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                "\"tid\":%d,\"args\":{\"name\":\"thread-%d\"}}",
+                firstEvent ? "" : ",", buffer->tid, buffer->tid);
+        firstEvent = false;
+        for (const TraceEvent& event : buffer->events) {
+            if (event.phase == 'C') {
+                counterEvents.push_back(std::make_pair(buffer->tid, &event));
+                continue;
+            }
+            fprintf(file, ",\n{\"name\":");
+            writeJsonString(file, event.name);
+            fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,"
+                    "\"dur\":%lld}", buffer->tid,
+                    static_cast<long long>(event.timestamp),
+                    static_cast<long long>(event.value));
+        }
+        for (auto& item : buffer->histograms) {
+            TraceHistogram& histogram = histograms[item.first];
+            const TraceHistogram& bufferHistogram = item.second;
+            if (histogram.count == 0 || bufferHistogram.min < histogram.min) {
+                histogram.min = bufferHistogram.min;
+            }
+            if (histogram.count == 0 || bufferHistogram.max > histogram.max) {
+                histogram.max = bufferHistogram.max;
+            }
+            histogram.count += bufferHistogram.count;
+            histogram.sum += bufferHistogram.sum;
+            for (int i = 0; i < 64; i++) {
+                histogram.buckets[i] += bufferHistogram.buckets[i];
+            }
+        }
+        droppedCount += buffer->droppedCount;
+    }
+    std::stable_sort(counterEvents.begin(), counterEvents.end(),
+            [](const std::pair<int, const TraceEvent*>& a,
+            const std::pair<int, const TraceEvent*>& b) {
+                return a.second->timestamp < b.second->timestamp;
+            });
+    std::map<std::string, int64_t> counters;
+    for (auto& item : counterEvents) {
+        const TraceEvent& event = *item.second;
+        int64_t& counter = counters[event.name];
+        counter += event.value;
+        fprintf(file, ",\n{\"name\":");
+        writeJsonString(file, event.name);
+        fprintf(file, ",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%lld,"
+                "\"args\":{\"value\":%lld}}", item.first,
+                static_cast<long long>(event.timestamp),
+                static_cast<long long>(counter));
+    }
+    for (TraceBuffer* buffer : traceBuffers) {
+        buffer->lock.unlock();
+    }
+    // 直方图不属于Chrome Trace的事件，作为额外的字段输出
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\",\"droppedEvents\":%lld,"
+            "\"histograms\":{", static_cast<long long>(droppedCount));
+    bool firstHistogram = true;
+    for (auto& item : histograms) {
+        const TraceHistogram& histogram = item.second;
+        fprintf(file, "%s\n", firstHistogram ? "" : ",");
+        firstHistogram = false;
+        writeJsonString(file, item.first.c_str());
+        fprintf(file, ":{\"count\":%lld,\"sum\":%.17g,\"min\":%.17g,"
+                "\"max\":%.17g,\"buckets\":{",
+                static_cast<long long>(histogram.count), histogram.sum,
+                histogram.min, histogram.max);
+        bool firstBucket = true;
+        for (int i = 0; i < 64; i++) {
+            if (histogram.buckets[i] == 0) {
+                continue;
+            }
+            // 使用桶的上界作为键
+            fprintf(file, "%s\"%.17g\":%lld", firstBucket ? "" : ",",
+                    std::ldexp(1.0, i), static_cast<long long>(
+                    histogram.buckets[i]));
+            firstBucket = false;
+        }
+        fprintf(file, "}}");
+    }
+    fprintf(file, "\n}}\n");
+    fclose(file);
+    return 0;
 }
 
 } //namespace program_helper
@@ -5,6 +5,11 @@
 #include <vector>
 #include <mutex>
 #include <map>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
 
 #define CHECK_EXIT(expr, info, ...) { \
     int errCode = expr; \
@@ -43,38 +48,127 @@
     } \
 }
 
+// 追踪宏，编译时定义PROGRAM_HELPER_TRACE才会生效，否则展开为空
+// 名字必须是字符串常量，记录时不会复制
+#ifdef PROGRAM_HELPER_TRACE
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) \
+    program_helper::TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define TRACE_COUNTER(name, value) { \
+    if (program_helper::Trace::isEnabled()) { \
+        program_helper::Trace::addCounter(name, value); \
+    } \
+}
+#define TRACE_HISTOGRAM(name, value) { \
+    if (program_helper::Trace::isEnabled()) { \
+        program_helper::Trace::addHistogram(name, value); \
+    } \
+}
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_COUNTER(name, value)
+#define TRACE_HISTOGRAM(name, value)
+#endif
+
 namespace program_helper {
 
+// 进度的统计信息
+struct ProgressInfo {
+    // 进度的名字，子进度为从根进度开始以'/'连接的路径
+    std::string name;
+    // 当前进度数值与总进度数值(父进度为按权重折算之后的数值)
+    int count;
+    int totalCount;
+    // 完成的百分比
+    double percentage;
+    // 平滑之后的处理速度，单位为每秒的进度数值
+    double rate;
+    // 预计剩余时间(速度未知时为-1)与已运行时间，单位为秒
+    double eta;
+    double elapsed;
+};
+
+// 进度更新时的回调函数，在显示线程中调用
+typedef std::function<void(const ProgressInfo&)> ProgressCallback;
+
+// 进度树中的节点，由根进度统一创建、统计和释放
+struct ProgressNode;
+
 // 多线程支持的自适应进度条显示类
+// 进度数值使用原子计数，由独立的显示线程按固定频率刷新终端输出
+// 子进度挂在父进度下面组成进度树，由根进度的显示线程统一显示
 class Progress {
 public:
+    // 进度的输出方式
+    enum OutputMode {
+        // 终端下显示进度条，否则输出结构化日志
+        AUTO_OUTPUT,
+        // 显示刷新的进度条
+        BAR_OUTPUT,
+        // 周期性输出一行结构化日志
+        LOG_OUTPUT,
+        // 不输出任何信息，只调用回调函数
+        NO_OUTPUT
+    };
+
     // 构造函数
     Progress(const int totalCount);
+    // 构造函数(指定输出方式和回调函数)
+    Progress(const int totalCount, const OutputMode outputMode,
+            ProgressCallback callback = nullptr);
+    // 构造带名字的根进度
+    Progress(const std::string& name, const int totalCount,
+            const OutputMode outputMode = AUTO_OUTPUT,
+            ProgressCallback callback = nullptr);
+    // 构造子进度，weight为子进度完成时在父进度中折算的进度数值
+    // 父进度的完成度为自身进度加上各子进度按权重折算的进度
+    // 子进度必须在根进度之前析构
+    Progress(Progress* parent, const std::string& name, const int totalCount,
+            const double weight = 1);
     // 析构函数
     ~Progress();
-    // 添加新的进度数值
+    // 添加新的进度数值(无锁，不会阻塞在终端输出上)
     void addProgress(const int newProgress);
 
 private:
-    // 打印信息
-    void dumpProgress();
+    // 显示线程的执行函数
+    void reportProgress();
+    // 统计节点及其子节点的进度，返回节点进度是否有变化
+    bool updateProgress(ProgressNode* node, const std::string& path,
+            const int depth, const bool final);
+    // 打印单个进度条信息
+    void dumpProgress(const ProgressInfo& info);
+    // 打印整棵进度树，每个进度占一行
+    void dumpTree();
+    // 打印结构化日志信息
+    void logProgress(const ProgressInfo& info);
+
+    // 进度树中对应的节点
+    ProgressNode* node_;
+    // 是否为根进度(根进度拥有整棵进度树和显示线程)
+    const bool isRoot_;
+
+    // 显示线程以及用于唤醒显示线程的同步变量
+    std::thread reporter_;
+    std::mutex reporterLock_;
+    std::condition_variable reporterCond_;
+    bool stopped_ = false;
 
-    // 支持多线程进度条
-    std::mutex progressLock_;
-    
     // 当前进度条的总长度
-    int barLength_;
+    int barLength_ = 0;
     // 当前要写的barCount
     int barCount_ = 0;
     // 进度条
-    char* progressBar_;
-    
-    // 当前进度的百分比
-    double percentage_ = 0;
-    // 当前进度的实际数值
-    int progressCount_ = 0;
-    // 总进度数值
-    const int totalCount_;
+    char* progressBar_ = nullptr;
+    // 单个进度条是否停留在未换行的状态
+    bool lineOpen_ = false;
+    // 进度树上一次显示占用的行数
+    int treeLines_ = 0;
+    // 实际使用的输出方式
+    OutputMode outputMode_ = NO_OUTPUT;
+    // 进度更新时的回调函数
+    ProgressCallback callback_;
 
     // 进度条为空显示的字符
     static const char emptyBarUnit;
@@ -82,6 +176,100 @@ private:
     static const char fullBarUnit;
     // 进度条的最长长度
     static const int maxLength;
+    // 进度树中名字的显示宽度
+    static const int nameLength;
+    // 进度条刷新间隔，单位为毫秒
+    static const int refreshInterval;
+    // 结构化日志的输出间隔，单位为毫秒
+    static const int logInterval;
+    // 处理速度指数平滑的时间常数，单位为秒
+    static const double rateSmoothing;
+};
+
+// 工作线程本地的进度累加器，攒够一批之后再提交到进度条
+// 析构时会提交剩余的进度，只能在单个线程内使用
+class ProgressBatch {
+public:
+    // 构造函数
+    ProgressBatch(Progress* progress, const int batchSize = 16) :
+            progress_(progress), batchSize_(batchSize) {}
+    // 析构函数
+    ~ProgressBatch() {
+        flush();
+    }
+    // 添加新的进度数值
+    void addProgress(const int newProgress) {
+        pendingCount_ += newProgress;
+        if (pendingCount_ >= batchSize_) {
+            flush();
+        }
+    }
+    // 提交当前累积的进度数值
+    void flush() {
+        if (pendingCount_ != 0) {
+            progress_->addProgress(pendingCount_);
+            pendingCount_ = 0;
+        }
+    }
+
+private:
+    // 目标进度条
+    Progress* progress_;
+    // 每批提交的进度数值
+    const int batchSize_;
+    // 尚未提交的进度数值
+    int pendingCount_ = 0;
+};
+
+// 低开销的追踪工具，记录耗时区间、计数器和直方图
+// 数据写入每个线程自己的缓冲区，保存为Chrome Trace/Perfetto可以打开的JSON文件
+// 未开启记录时每次调用只有一次原子读
+class Trace {
+public:
+    // 开始记录(会清空之前记录的数据)
+    static void start();
+    // 停止记录
+    static void stop();
+    // 是否正在记录
+    static bool isEnabled() {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+    // 将记录的数据保存为JSON文件(需要在所有记录线程结束记录之后调用)
+    static int save(const std::string& filePath);
+
+    // 当前时间，单位为微秒
+    static int64_t now();
+    // 记录一个耗时区间
+    static void addSpan(const char* name, const int64_t startTime,
+            const int64_t endTime);
+    // 给计数器增加数值
+    static void addCounter(const char* name, const int64_t value);
+    // 记录一个直方图样本
+    static void addHistogram(const char* name, const double value);
+
+private:
+    // 是否正在记录
+    static std::atomic<bool> enabled_;
+};
+
+// 记录所在作用域耗时的RAII对象，一般通过TRACE_SCOPE宏使用
+class TraceScope {
+public:
+    // 构造函数
+    TraceScope(const char* name) : name_(name),
+            startTime_(Trace::isEnabled() ? Trace::now() : -1) {}
+    // 析构函数
+    ~TraceScope() {
+        if (startTime_ >= 0) {
+            Trace::addSpan(name_, startTime_, Trace::now());
+        }
+    }
+
+private:
+    // 区间的名字
+    const char* name_;
+    // 区间的开始时间，未开启记录时为-1
+    const int64_t startTime_;
 };
 
 } //namespace program_helper
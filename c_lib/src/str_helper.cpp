@@ -2,14 +2,31 @@
 #include <wchar.h>
 #include <memory.h>
 #include <regex>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <iostream>
 #include <cctype>
-#ifdef WIN32
-#include <windows.h>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <cerrno>
+#include <climits>
+#include <limits>
+#include <locale.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
 #endif
 
 namespace htk
 {
+    // gb18030_table.cpp
+    extern const uint16_t GB18030_TWO_BYTE[126 * 190];
+    extern const size_t GB18030_RANGE_COUNT;
+    extern const uint32_t GB18030_RANGE_LINEAR[];
+    extern const uint32_t GB18030_RANGE_CODE[];
+
     std::vector<std::string> split(const std::string &str, 
         const std::string &delimiter, const std::string& trim_str)
     {
@@ -80,6 +97,43 @@ namespace htk
         return v;
     }
 
+    size_t split_view(const StringView& str, const StringView& delimiter,
+        std::vector<StringView>& tokens, const StringView& trim_str)
+    {
+        tokens.clear();
+        const CharSet trim_set(trim_str);
+        for_each_token(str, delimiter, [&](const StringView& token) {
+            tokens.push_back(trim_view(token, trim_set));
+            return true;
+        });
+        return tokens.size();
+    }
+
+    size_t split_with_quot_view(const StringView& str, const char delimiter,
+        std::vector<StringView>& tokens, const char quot, const StringView& trim_str)
+    {
+        tokens.clear();
+        const CharSet trim_set(trim_str);
+        bool quot_status = false;
+        size_t start = 0;
+        for (size_t i = 0; i < str.size(); ++i)
+        {
+            char ch = str[i];
+            if (ch == quot) quot_status = !quot_status;    // л״̬
+            else if (!quot_status && ch == delimiter)
+            {
+                tokens.push_back(trim_view(str.substr(start, i - start), trim_set));
+                start = i + 1;
+            }
+        }
+        // split_with_quotһ£Էָβʱ(δպϵеķָ)һ
+        if (start < str.size() && str[str.size() - 1] != delimiter)
+        {
+            tokens.push_back(trim_view(str.substr(start), trim_set));
+        }
+        return tokens.size();
+    }
+
     std::string join(const std::vector<std::string> vec, const std::string & delimiter)
     {
         size_t n = vec.size();
@@ -100,37 +154,35 @@ namespace htk
 
     std::string trim_left(const std::string & str, const std::string & sub_str)
     {
-        std::string rev(str);
-        size_t start = rev.find_first_not_of(sub_str);
-        if (start == std::string::npos)
-        {
-            rev.clear();
-        }
-        else
-        {
-            rev = rev.substr(start, str.size() - start + 1);
-        }
-        return rev;
+        return trim_left_view(str, CharSet(sub_str)).str();
     }
 
     std::string trim_right(const std::string & str, const std::string & sub_str)
     {
-        std::string rev(str);
-        size_t end = rev.find_last_not_of(sub_str);
-        if (end == std::string::npos)
-        {
-            rev.clear();
-        }
-        else
-        {
-            rev = rev.substr(0, end + 1);
-        }
-        return rev;
+        return trim_right_view(str, CharSet(sub_str)).str();
     }
 
     std::string trim(const std::string & str, const std::string & sub_str)
     {
-        return trim_right(trim_left(str, sub_str), sub_str);
+        return trim_view(str, CharSet(sub_str)).str();
+    }
+
+    std::string& trim_left_inplace(std::string& str, const CharSet& chars)
+    {
+        size_t start = trim_left_view(str, chars).data() - str.data();
+        str.erase(0, start);
+        return str;
+    }
+
+    std::string& trim_right_inplace(std::string& str, const CharSet& chars)
+    {
+        str.resize(trim_right_view(str, chars).size());
+        return str;
+    }
+
+    std::string& trim_inplace(std::string& str, const CharSet& chars)
+    {
+        return trim_left_inplace(trim_right_inplace(str, chars), chars);
     }
 
     std::wstring String2Wstring(const std::string & str, const char* encoding)
@@ -172,44 +224,12 @@ namespace htk
 
     std::string GBK2UTF8(const std::string& strGBK)
     {
-#ifdef WIN32
-        int len = MultiByteToWideChar(CP_ACP, 0, strGBK.c_str(), -1, NULL, 0);
-        wchar_t* wstr = new wchar_t[len + 1];
-        memset(wstr, 0, len + 1);
-        MultiByteToWideChar(CP_ACP, 0, strGBK.c_str(), -1, wstr, len);
-        len = WideCharToMultiByte(CP_UTF8, 0, wstr, -1, NULL, 0, NULL, NULL);
-        char* str = new char[len + 1];
-        memset(str, 0, len + 1);
-        WideCharToMultiByte(CP_UTF8, 0, wstr, -1, str, len, NULL, NULL);
-        std::string strTemp = str;
-        if (wstr) delete[] wstr;
-        if (str) delete[] str;
-        return strTemp;
-#else
-        std::wstring w_str = String2Wstring(strGBK, "zh_CN.18030");
-        return Wstring2String(w_str, "zh_CN.utf8");
-#endif
+        return gb18030_to_utf8(strGBK);
     }
 
     std::string UTF82GBK(const std::string& strUTF8)
     {
-#ifdef WIN32
-        int len = MultiByteToWideChar(CP_UTF8, 0, strUTF8.c_str(), -1, NULL, 0);
-        wchar_t* wszGBK = new wchar_t[len + 1];
-        memset(wszGBK, 0, len * 2 + 2);
-        MultiByteToWideChar(CP_UTF8, 0, strUTF8.c_str(), -1, wszGBK, len);
-        len = WideCharToMultiByte(CP_ACP, 0, wszGBK, -1, NULL, 0, NULL, NULL);
-        char* szGBK = new char[len + 1];
-        memset(szGBK, 0, len + 1);
-        WideCharToMultiByte(CP_ACP, 0, wszGBK, -1, szGBK, len, NULL, NULL);
-        std::string strTemp(szGBK);
-        if (wszGBK) delete[] wszGBK;
-        if (szGBK) delete[] szGBK;
-        return strTemp;
-#else
-        std::wstring w_str = String2Wstring(strUTF8, "zh_CN.utf8");
-        return Wstring2String(w_str, "zh_CN.gb18030");
-#endif
+        return utf8_to_gb18030(strUTF8);
     }
 
     std::string wstring2string(const std::wstring & str, const std::string & locale_str)
@@ -226,385 +246,2139 @@ namespace htk
         return conv.from_bytes(str);
     }
 
+    // Ƿ滻ΪU+FFFD׳쳣
     std::string unicode_to_utf8(const std::wstring & str)
     {
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        return conv.to_bytes(str);
+        std::string res;
+        AppendWideToUTF8(str, res);
+        return res;
     }
 
     std::wstring utf8_to_unicode(const std::string & str)
     {
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        return conv.from_bytes(str);
+        std::wstring res;
+        AppendUTF8ToWide(str, res);
+        return res;
     }
 
     std::string unicode_to_gb18030(const std::wstring & str)
     {
-#ifdef WIN32
-        return wstring2string(str, ".54936");
-#else
-        return wstring2string(str, "zh_CN.gb18030");
-#endif
+        return utf8_to_gb18030(unicode_to_utf8(str));
     }
 
     std::wstring gb18030_to_unicode(const std::string & str)
     {
-#ifdef WIN32
-        return string2wstring(str, ".54936");
-#else
-        return string2wstring(str, "zh_CN.gb18030");
-#endif
+        return utf8_to_unicode(gb18030_to_utf8(str));
     }
 
     std::string utf8_to_gb18030(const std::string & str)
     {
-        return unicode_to_gb18030(utf8_to_unicode(str));
+        std::string res;
+        AppendUTF8ToGB18030(str, res);
+        return res;
     }
 
     std::string gb18030_to_utf8(const std::string & str)
     {
-        return unicode_to_utf8(gb18030_to_unicode(str));
+        std::string res;
+        AppendGB18030ToUTF8(str, res);
+        return res;
     }
 
-    bool isInt(const std::string & str)
+    // s[i]ʼһUTF-8УiǰһСǷʱiͣǷ֮
+    // ϷĺֽʱĸֽڣWHATWGUnicodeƼ滻ʽһ
+    static inline bool DecodeUTF8Char(const unsigned char* s, size_t size, size_t& i, uint32_t& cp)
     {
-        // TODO
-        return false;
+        unsigned char c = s[i++];
+        if (c < 0x80)
+        {
+            cp = c;
+            return true;
+        }
+        int need;
+        unsigned char lower = 0x80, upper = 0xBF;
+        if (c >= 0xC2 && c <= 0xDF)
+        {
+            need = 1;
+            cp = c & 0x1F;
+        }
+        else if (c >= 0xE0 && c <= 0xEF)
+        {
+            need = 2;
+            cp = c & 0x0F;
+            if (c == 0xE0) lower = 0xA0;        // 
+            else if (c == 0xED) upper = 0x9F;   // 
+        }
+        else if (c >= 0xF0 && c <= 0xF4)
+        {
+            need = 3;
+            cp = c & 0x07;
+            if (c == 0xF0) lower = 0x90;        // 
+            else if (c == 0xF4) upper = 0x8F;   // U+10FFFF
+        }
+        else
+        {
+            return false;
+        }
+        for (int k = 0; k < need; ++k)
+        {
+            if (i >= size || s[i] < lower || s[i] > upper) return false;
+            cp = (cp << 6) | (s[i++] & 0x3F);
+            lower = 0x80;
+            upper = 0xBF;
+        }
+        return true;
     }
 
-    bool isFloat(const std::string & str)
+    // iʼĴASCII16ֽڿ
+    static inline size_t SkipASCII(const unsigned char* s, size_t size, size_t i)
     {
-        // TODO
-        return false;
+#if defined(__SSE2__)
+        for (; i + 16 <= size; i += 16)
+        {
+            if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i))) != 0) break;
+        }
+#endif
+        return i;
     }
 
-    bool isBool(const std::string & str)
+    bool IsValidUTF8(const char* data, size_t size, size_t* error_pos)
     {
-        // TODO
-        return false;
+        const unsigned char* s = reinterpret_cast<const unsigned char*>(data);
+        size_t i = 0;
+        while (i < size)
+        {
+            i = SkipASCII(s, size, i);
+            if (i == size) break;
+            size_t start = i;
+            uint32_t cp;
+            if (!DecodeUTF8Char(s, size, i, cp))
+            {
+                if (error_pos) *error_pos = start;
+                return false;
+            }
+        }
+        return true;
     }
 
-    bool RegexSearch(const std::string & str, const std::string & reg_str)
+    // UnitΪԪͣsizeof(Unit) == 2ʱUTF-16UTF-32
+    template <typename Unit>
+    static size_t DecodeUTF8(const char* src, size_t size, Unit* dst, TranscodePolicy policy, size_t* error_pos)
     {
-        try
-        {
-            const std::regex pattern(reg_str);
-            return std::regex_search(str, pattern);
-        }
-        catch (const std::exception&)
+        const unsigned char* s = reinterpret_cast<const unsigned char*>(src);
+        size_t i = 0, n = 0;
+        while (i < size)
         {
-            std::cerr << "regex error: " << reg_str << std::endl;
-            return false;
+#if defined(__SSE2__)
+            // ASCIIֱչд
+            const __m128i zero = _mm_setzero_si128();
+            for (; i + 16 <= size; i += 16, n += 16)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+                if (_mm_movemask_epi8(v) != 0) break;
+                __m128i lo = _mm_unpacklo_epi8(v, zero);
+                __m128i hi = _mm_unpackhi_epi8(v, zero);
+                __m128i* out = reinterpret_cast<__m128i*>(dst + n);
+                if (sizeof(Unit) == 2)
+                {
+                    _mm_storeu_si128(out, lo);
+                    _mm_storeu_si128(out + 1, hi);
+                }
+                else
+                {
+                    _mm_storeu_si128(out, _mm_unpacklo_epi16(lo, zero));
+                    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo, zero));
+                    _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi, zero));
+                    _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi, zero));
+                }
+            }
+            if (i == size) break;
+#endif
+            size_t start = i;
+            uint32_t cp;
+            if (!DecodeUTF8Char(s, size, i, cp))
+            {
+                if (policy == TRANSCODE_FAIL)
+                {
+                    if (error_pos) *error_pos = start;
+                    return TRANSCODE_ERROR;
+                }
+                if (policy == TRANSCODE_SKIP) continue;
+                cp = 0xFFFD;
+            }
+            if (sizeof(Unit) == 2 && cp >= 0x10000)
+            {
+                cp -= 0x10000;
+                dst[n++] = static_cast<Unit>(0xD800 + (cp >> 10));
+                dst[n++] = static_cast<Unit>(0xDC00 + (cp & 0x3FF));
+            }
+            else
+            {
+                dst[n++] = static_cast<Unit>(cp);
+            }
         }
+        return n;
     }
 
-    bool RegexSearch(const std::wstring & wstr, const std::wstring & wreg_str)
+    // дϷUTF-8룬ֽ
+    static inline size_t PutUTF8(uint32_t cp, char* dst)
     {
-        try
+        if (cp < 0x80)
         {
-            const std::wregex pattern(wreg_str);
-            return std::regex_search(wstr, pattern);
+            dst[0] = static_cast<char>(cp);
+            return 1;
         }
-        catch (const std::exception&)
+        if (cp < 0x800)
         {
-            std::wcerr << "regex error: " << wreg_str << std::endl;
-            return false;
+            dst[0] = static_cast<char>(0xC0 | (cp >> 6));
+            dst[1] = static_cast<char>(0x80 | (cp & 0x3F));
+            return 2;
+        }
+        if (cp < 0x10000)
+        {
+            dst[0] = static_cast<char>(0xE0 | (cp >> 12));
+            dst[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            dst[2] = static_cast<char>(0x80 | (cp & 0x3F));
+            return 3;
         }
+        dst[0] = static_cast<char>(0xF0 | (cp >> 18));
+        dst[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        dst[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        dst[3] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 4;
     }
 
-    bool RegexSearch(const std::string & str, std::vector<std::string>& result, const std::string & reg_str)
+    // UnitΪԪͣsizeof(Unit) == 2ʱUTF-16UTF-32
+    template <typename Unit>
+    static size_t EncodeUTF8(const Unit* src, size_t size, char* dst, TranscodePolicy policy, size_t* error_pos)
     {
-        try
+        size_t i = 0, n = 0;
+        while (i < size)
         {
-            const std::regex pattern(reg_str);
-            std::smatch mat;
-            if (std::regex_search(str, mat, pattern))
+#if defined(__SSE2__)
+            // 16ԪС0x80ʱֱխд
+            const __m128i zero = _mm_setzero_si128();
+            for (; i + 16 <= size; i += 16, n += 16)
+            {
+                const __m128i* in = reinterpret_cast<const __m128i*>(src + i);
+                __m128i packed;
+                if (sizeof(Unit) == 2)
+                {
+                    __m128i a = _mm_loadu_si128(in), b = _mm_loadu_si128(in + 1);
+                    __m128i high = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi16(static_cast<short>(0xFF80)));
+                    if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) != 0xFFFF) break;
+                    packed = _mm_packus_epi16(a, b);
+                }
+                else
+                {
+                    __m128i a = _mm_loadu_si128(in), b = _mm_loadu_si128(in + 1);
+                    __m128i c = _mm_loadu_si128(in + 2), d = _mm_loadu_si128(in + 3);
+                    __m128i all = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+                    __m128i high = _mm_and_si128(all, _mm_set1_epi32(static_cast<int>(0xFFFFFF80)));
+                    if (_mm_movemask_epi8(_mm_cmpeq_epi32(high, zero)) != 0xFFFF) break;
+                    packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + n), packed);
+            }
+            if (i == size) break;
+#endif
+            size_t start = i;
+            uint32_t cp = sizeof(Unit) == 2 ? static_cast<uint16_t>(src[i]) : static_cast<uint32_t>(src[i]);
+            ++i;
+            bool valid = true;
+            if (sizeof(Unit) == 2 && cp >= 0xD800 && cp <= 0xDFFF)
+            {
+                uint32_t low = i < size ? static_cast<uint16_t>(src[i]) : 0;
+                if (cp <= 0xDBFF && low >= 0xDC00 && low <= 0xDFFF)
+                {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    ++i;
+                }
+                else
+                {
+                    valid = false;
+                }
+            }
+            else if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+            {
+                valid = false;
+            }
+            if (!valid)
             {
-                result.clear();
-                result.reserve(mat.size());
-                result.insert(result.begin(), mat.begin(), mat.end());
-                return true;
+                if (policy == TRANSCODE_FAIL)
+                {
+                    if (error_pos) *error_pos = start;
+                    return TRANSCODE_ERROR;
+                }
+                if (policy == TRANSCODE_SKIP) continue;
+                cp = 0xFFFD;
             }
+            n += PutUTF8(cp, dst + n);
         }
-        catch (const std::exception&)
+        return n;
+    }
+
+    size_t UTF8ToUTF16(const char* src, size_t size, char16_t* dst, TranscodePolicy policy, size_t* error_pos)
+    {
+        return DecodeUTF8(src, size, dst, policy, error_pos);
+    }
+
+    size_t UTF8ToUTF32(const char* src, size_t size, char32_t* dst, TranscodePolicy policy, size_t* error_pos)
+    {
+        return DecodeUTF8(src, size, dst, policy, error_pos);
+    }
+
+    size_t UTF16ToUTF8(const char16_t* src, size_t size, char* dst, TranscodePolicy policy, size_t* error_pos)
+    {
+        return EncodeUTF8(src, size, dst, policy, error_pos);
+    }
+
+    size_t UTF32ToUTF8(const char32_t* src, size_t size, char* dst, TranscodePolicy policy, size_t* error_pos)
+    {
+        return EncodeUTF8(src, size, dst, policy, error_pos);
+    }
+
+    // Ȱ󳤶ݣתضϵʵʳ
+    template <typename Unit>
+    static bool AppendDecoded(const StringView& src, std::basic_string<Unit>& out, TranscodePolicy policy)
+    {
+        size_t old_size = out.size();
+        out.resize(old_size + src.size());
+        size_t n = src.empty() ? 0 : DecodeUTF8(src.data(), src.size(), &out[old_size], policy, NULL);
+        if (n == TRANSCODE_ERROR)
         {
-            std::cerr << "regex error: " << reg_str << std::endl;
+            out.resize(old_size);
+            return false;
         }
-        return false;
+        out.resize(old_size + n);
+        return true;
     }
 
-    bool RegexSearch(const std::wstring & wstr, std::vector<std::wstring>& result, const std::wstring & wreg_str)
+    template <typename Unit>
+    static bool AppendEncoded(const std::basic_string<Unit>& src, std::string& out, TranscodePolicy policy)
     {
-        try
+        size_t old_size = out.size();
+        out.resize(old_size + src.size() * (sizeof(Unit) == 2 ? 3 : 4));
+        size_t n = src.empty() ? 0 : EncodeUTF8(src.data(), src.size(), &out[old_size], policy, NULL);
+        if (n == TRANSCODE_ERROR)
         {
-            const std::wregex pattern(wreg_str);
-            std::wsmatch mat;
-            if (std::regex_search(wstr, mat, pattern))
-            {
-                result.clear();
-                result.reserve(mat.size());
-                result.insert(result.begin(), mat.begin(), mat.end());
-                return true;
-            }
+            out.resize(old_size);
+            return false;
         }
-        catch (const std::exception&)
+        out.resize(old_size + n);
+        return true;
+    }
+
+    bool AppendUTF8ToUTF16(const StringView& src, std::u16string& out, TranscodePolicy policy)
+    {
+        return AppendDecoded(src, out, policy);
+    }
+
+    bool AppendUTF8ToUTF32(const StringView& src, std::u32string& out, TranscodePolicy policy)
+    {
+        return AppendDecoded(src, out, policy);
+    }
+
+    bool AppendUTF8ToWide(const StringView& src, std::wstring& out, TranscodePolicy policy)
+    {
+        return AppendDecoded(src, out, policy);
+    }
+
+    bool AppendUTF16ToUTF8(const std::u16string& src, std::string& out, TranscodePolicy policy)
+    {
+        return AppendEncoded(src, out, policy);
+    }
+
+    bool AppendUTF32ToUTF8(const std::u32string& src, std::string& out, TranscodePolicy policy)
+    {
+        return AppendEncoded(src, out, policy);
+    }
+
+    bool AppendWideToUTF8(const std::wstring& src, std::string& out, TranscodePolicy policy)
+    {
+        return AppendEncoded(src, out, policy);
+    }
+
+    // ֽ0x90308130ӦU+10000֮ƽ
+    static const uint32_t GB18030_SUPPLEMENT_LINEAR = 189000;
+    static const uint32_t GB18030_BMP_LINEAR_END = 39420;
+
+    // Unicode BMP˫ֽķ״ʹʱGB18030_TWO_BYTEɣ0ʾû˫ֽ
+    static const uint16_t* GB18030ReverseTable()
+    {
+        struct ReverseTable
         {
-            std::wcerr << "regex error: " << wreg_str << std::endl;
-        }
-        return false;
+            uint16_t codes[0x10000];
+            ReverseTable()
+            {
+                memset(codes, 0, sizeof(codes));
+                for (int i = 126 * 190 - 1; i >= 0; --i)
+                {
+                    int trail = i % 190;
+                    codes[GB18030_TWO_BYTE[i]] = static_cast<uint16_t>(((0x81 + i / 190) << 8) | (trail + (trail < 0x3F ? 0x40 : 0x41)));
+                }
+            }
+        };
+        static const ReverseTable table;
+        return table.codes;
     }
 
-    bool RegexMatch(const std::string & str, const std::string & reg_str)
+    // s[i]ʼһGB18030ַPythongb18030һ£
+    // Ƿʱֻֽڣֽ뵫ĩβضʱʣֽΪһǷ
+    static inline bool DecodeGB18030Char(const unsigned char* s, size_t size, size_t& i, uint32_t& cp)
     {
-        try
+        unsigned char c1 = s[i];
+        if (c1 < 0x80)
         {
-            const std::regex pattern(reg_str);
-            return std::regex_match(str, pattern);
+            cp = c1;
+            ++i;
+            return true;
         }
-        catch (const std::exception&)
+        if (i + 1 == size)
         {
-            std::cerr << "regex error: " << reg_str << std::endl;
+            ++i;
             return false;
         }
-    }
-
-    bool RegexMatch(const std::wstring & wstr, const std::wstring & wreg_str)
-    {
-        try
+        unsigned char c2 = s[i + 1];
+        if (c2 >= 0x30 && c2 <= 0x39 && size - i < 4)
         {
-            const std::wregex pattern(wreg_str);
-            return std::regex_match(wstr, pattern);
+            i = size;
+            return false;
         }
-        catch (const std::exception&)
+        if (c1 == 0x80 || c1 == 0xFF)
         {
-            std::wcerr << "regex error: " << wreg_str << std::endl;
+            ++i;
             return false;
         }
-    }
-
-    bool RegexMatch(const std::string & str, std::vector<std::string>& result, const std::string & reg_str)
-    {
-        try
+        if ((c2 >= 0x40 && c2 <= 0x7E) || (c2 >= 0x80 && c2 <= 0xFE))
         {
-            const std::regex pattern(reg_str);
-            std::smatch mat;
-            if (std::regex_match(str, mat, pattern))
-            {
-                result.clear();
-                result.reserve(mat.size());
-                result.insert(result.begin(), mat.begin(), mat.end());
-                return true;
-            }
+            cp = GB18030_TWO_BYTE[(c1 - 0x81) * 190 + c2 - (c2 < 0x80 ? 0x40 : 0x41)];
+            i += 2;
+            return true;
         }
-        catch (const std::exception&)
+        if (c2 < 0x30 || c2 > 0x39)
         {
-            std::cerr << "regex error: " << reg_str << std::endl;
+            ++i;
+            return false;
         }
-        return false;
+        unsigned char c3 = s[i + 2], c4 = s[i + 3];
+        if (c3 < 0x81 || c3 > 0xFE || c4 < 0x30 || c4 > 0x39)
+        {
+            ++i;
+            return false;
+        }
+        uint32_t linear = ((c1 - 0x81) * 10 + (c2 - 0x30)) * 1260 + (c3 - 0x81) * 10 + (c4 - 0x30);
+        if (linear < GB18030_BMP_LINEAR_END)
+        {
+            const uint32_t* end = GB18030_RANGE_LINEAR + GB18030_RANGE_COUNT;
+            size_t k = std::upper_bound(GB18030_RANGE_LINEAR, end, linear) - GB18030_RANGE_LINEAR - 1;
+            cp = GB18030_RANGE_CODE[k] + linear - GB18030_RANGE_LINEAR[k];
+        }
+        else if (linear >= GB18030_SUPPLEMENT_LINEAR && linear - GB18030_SUPPLEMENT_LINEAR <= 0x10FFFF - 0x10000)
+        {
+            cp = 0x10000 + linear - GB18030_SUPPLEMENT_LINEAR;
+        }
+        else
+        {
+            ++i;
+            return false;
+        }
+        i += 4;
+        return true;
     }
 
-    bool RegexMatch(const std::wstring & wstr, std::vector<std::wstring>& result, const std::wstring & wreg_str)
+    // дGB18030룬ֽ
+    static inline size_t EncodeGB18030Char(uint32_t cp, const uint16_t* reverse, char* dst)
     {
-        try
+        if (cp < 0x80)
+        {
+            dst[0] = static_cast<char>(cp);
+            return 1;
+        }
+        uint32_t linear;
+        if (cp < 0x10000)
         {
-            const std::wregex pattern(wreg_str);
-            std::wsmatch mat;
-            if (std::regex_match(wstr, mat, pattern))
+            uint16_t code = reverse[cp];
+            if (code != 0)
             {
-                result.clear();
-                result.reserve(mat.size());
-                result.insert(result.begin(), mat.begin(), mat.end());
-                return true;
+                dst[0] = static_cast<char>(code >> 8);
+                dst[1] = static_cast<char>(code & 0xFF);
+                return 2;
             }
+            const uint32_t* end = GB18030_RANGE_CODE + GB18030_RANGE_COUNT;
+            size_t k = std::upper_bound(GB18030_RANGE_CODE, end, cp) - GB18030_RANGE_CODE - 1;
+            linear = GB18030_RANGE_LINEAR[k] + cp - GB18030_RANGE_CODE[k];
         }
-        catch (const std::exception&)
+        else
         {
-            std::wcerr << "regex error: " << wreg_str << std::endl;
+            linear = GB18030_SUPPLEMENT_LINEAR + cp - 0x10000;
         }
-        return false;
+        dst[3] = static_cast<char>(0x30 + linear % 10);
+        linear /= 10;
+        dst[2] = static_cast<char>(0x81 + linear % 126);
+        linear /= 126;
+        dst[1] = static_cast<char>(0x30 + linear % 10);
+        dst[0] = static_cast<char>(0x81 + linear / 10);
+        return 4;
     }
 
-    std::string RegexReplace(const std::string & str, const std::string & reg_str, const std::string & sub_str)
+    // תsrcǰsizeֽڣʱlimit
+    // ʹֿתʱβĽضжתһ
+    static size_t GB18030ToUTF8Range(const char* src, size_t size, size_t limit, char* dst,
+        TranscodePolicy policy, size_t* error_pos)
     {
-        std::regex pattern(reg_str);
-        return regex_replace(str, pattern, sub_str);
+        const unsigned char* s = reinterpret_cast<const unsigned char*>(src);
+        size_t i = 0, n = 0;
+        while (i < size)
+        {
+            // ASCII鸴
+            size_t ascii_end = SkipASCII(s, size, i);
+            while (ascii_end < size && s[ascii_end] < 0x80) ++ascii_end;
+            if (ascii_end > i)
+            {
+                memcpy(dst + n, src + i, ascii_end - i);
+                n += ascii_end - i;
+                i = ascii_end;
+                if (i == size) break;
+            }
+            size_t start = i;
+            uint32_t cp;
+            if (!DecodeGB18030Char(s, limit, i, cp))
+            {
+                if (policy == TRANSCODE_FAIL)
+                {
+                    if (error_pos) *error_pos = start;
+                    return TRANSCODE_ERROR;
+                }
+                if (policy == TRANSCODE_SKIP) continue;
+                cp = 0xFFFD;
+            }
+            n += PutUTF8(cp, dst + n);
+        }
+        return n;
     }
 
-    std::wstring RegexReplace(const std::wstring & wstr, const std::wstring & wreg_str, const std::wstring & wsub_str)
+    size_t GB18030ToUTF8(const char* src, size_t size, char* dst, TranscodePolicy policy, size_t* error_pos)
     {
-        std::wregex pattern(wreg_str);
-        return regex_replace(wstr, pattern, wsub_str);
+        return GB18030ToUTF8Range(src, size, size, dst, policy, error_pos);
     }
 
-    std::string toLower(const std::string & str)
+    size_t UTF8ToGB18030(const char* src, size_t size, char* dst, TranscodePolicy policy, size_t* error_pos)
     {
-        std::istringstream is(str);
-        std::string lower_case_;
-        char c;
-        while (is.get(c)) {
-            if (isalpha(c)) {
-                if (isupper(c)) {
-                    c = static_cast<char> (std::tolower(c));
-                    lower_case_ += c;
+        const unsigned char* s = reinterpret_cast<const unsigned char*>(src);
+        const uint16_t* reverse = GB18030ReverseTable();
+        size_t i = 0, n = 0;
+        while (i < size)
+        {
+            size_t ascii_end = SkipASCII(s, size, i);
+            while (ascii_end < size && s[ascii_end] < 0x80) ++ascii_end;
+            if (ascii_end > i)
+            {
+                memcpy(dst + n, src + i, ascii_end - i);
+                n += ascii_end - i;
+                i = ascii_end;
+                if (i == size) break;
+            }
+            size_t start = i;
+            uint32_t cp;
+            if (!DecodeUTF8Char(s, size, i, cp))
+            {
+                if (policy == TRANSCODE_FAIL)
+                {
+                    if (error_pos) *error_pos = start;
+                    return TRANSCODE_ERROR;
                 }
-                else
-                    //is lower;
-                    lower_case_ += c;
+                if (policy == TRANSCODE_SKIP) continue;
+                cp = 0xFFFD;
             }
-            else
-                //is not alphabit;
-                lower_case_ += c;
+            n += EncodeGB18030Char(cp, reverse, dst + n);
         }
-        return lower_case_;
+        return n;
     }
 
-    std::string toUpper(const std::string & str)
+    bool AppendGB18030ToUTF8(const StringView& src, std::string& out, TranscodePolicy policy)
     {
-        std::istringstream is(str);
-        std::string upper_case_;
-        char c;
-        while (is.get(c)) {
-            if (isalpha(c)) {
-                if (islower(c)) {
-                    c = static_cast<char> (std::toupper(c));
-                    upper_case_ += c;
-                }
-                else
-                    // is upper;
-                    upper_case_ += c;
-            }
-            else
-                // is not alphabit;
-                upper_case_ += c;
+        size_t old_size = out.size();
+        out.resize(old_size + src.size() * 3);
+        size_t n = src.empty() ? 0 : GB18030ToUTF8(src.data(), src.size(), &out[old_size], policy, NULL);
+        if (n == TRANSCODE_ERROR)
+        {
+            out.resize(old_size);
+            return false;
         }
-        return upper_case_;
+        out.resize(old_size + n);
+        return true;
     }
 
-    enum CHARCLASS { CC_SBCSPACE, CC_DBCSPACE, CC_SBCCHAR, CC_DBCCHAR, CC_SBCCHINESE };
-
-    CHARCLASS GetCharClass(unsigned char c1, unsigned char c2)
+    bool AppendUTF8ToGB18030(const StringView& src, std::string& out, TranscodePolicy policy)
     {
-        if (c1 == 161 && c2 == 161)
+        size_t old_size = out.size();
+        out.resize(old_size + src.size() * 4);
+        size_t n = src.empty() ? 0 : UTF8ToGB18030(src.data(), src.size(), &out[old_size], policy, NULL);
+        if (n == TRANSCODE_ERROR)
         {
-            return CC_SBCSPACE;	//ȫǿոA1A1
+            out.resize(old_size);
+            return false;
         }
-        else if (c1 >= 161 && c1 <= 169)
+        out.resize(old_size + n);
+        return true;
+    }
+
+    // ͳһݰUTF-8GB18030ʱASCIIַͷǷеĸlimit֮ǰֽڶԶȡ
+    static void CountEncodingErrors(const unsigned char* s, size_t begin, size_t end, size_t limit,
+        bool utf8, size_t& chars, size_t& errors)
+    {
+        size_t i = begin;
+        while (i < end)
         {
-            return CC_SBCCHAR;//ȫַ
+            i = SkipASCII(s, end, i);
+            if (i == end) break;
+            if (s[i] < 0x80)
+            {
+                ++i;
+                continue;
+            }
+            uint32_t cp;
+            bool valid = utf8 ? DecodeUTF8Char(s, limit, i, cp) : DecodeGB18030Char(s, limit, i, cp);
+            if (valid)
+                ++chars;
+            else
+                ++errors;
         }
-        else if (c1 <= 127)
+    }
+
+    TextEncoding DetectEncoding(const char* data, size_t size, size_t sample_size)
+    {
+        const unsigned char* s = reinterpret_cast<const unsigned char*>(data);
+        if (size >= 3 && s[0] == 0xEF && s[1] == 0xBB && s[2] == 0xBF) return ENCODING_UTF8;
+
+        // ݽϴʱڿͷ1/32/3ͽβȡһΣмĶδӵһ֮ʼַм
+        std::vector<std::pair<size_t, size_t> > windows;
+        if (size <= sample_size || sample_size < 4)
         {
-            return (c1 != 32)
-                ? CC_DBCCHAR //Ӣĸ
-                : CC_DBCSPACE;//ǿո32
+            windows.push_back(std::make_pair(0, size));
         }
         else
         {
-            return CC_SBCCHINESE;//
-        }
+            size_t width = sample_size / 4;
+            size_t offsets[4] = { 0, size / 3, size / 3 * 2, size - width };
+            for (int k = 0; k < 4; ++k)
+            {
+                size_t begin = offsets[k], end = offsets[k] + width;
+                if (k > 0)
+                {
+                    const void* line_end = memchr(data + begin, '\n', width);
+                    if (line_end) begin = static_cast<const char*>(line_end) - data + 1;
+                }
+                windows.push_back(std::make_pair(begin, end));
+            }
+        }
+
+        size_t utf8_chars = 0, utf8_errors = 0, gb_chars = 0, gb_errors = 0;
+        for (size_t k = 0; k < windows.size(); ++k)
+        {
+            // βַ⣬һݽβΪ
+            size_t limit = std::min(size, windows[k].second + 3);
+            CountEncodingErrors(s, windows[k].first, windows[k].second, limit, true, utf8_chars, utf8_errors);
+            CountEncodingErrors(s, windows[k].first, windows[k].second, limit, false, gb_chars, gb_errors);
+        }
+        if (utf8_chars + utf8_errors == 0) return ENCODING_ASCII;
+        // UTF-8ĽṹԼǿGB18030ıζǺϷUTF-8
+        if (utf8_errors == 0) return ENCODING_UTF8;
+        if (gb_errors == 0) return ENCODING_GB18030;
+        // ߶зǷʱΪ𻵵ݣȡǷϵҲ10%һ
+        double utf8_ratio = static_cast<double>(utf8_errors) / (utf8_chars + utf8_errors);
+        double gb_ratio = static_cast<double>(gb_errors) / (gb_chars + gb_errors);
+        if (utf8_ratio <= gb_ratio && utf8_ratio < 0.1) return ENCODING_UTF8;
+        if (gb_ratio < utf8_ratio && gb_ratio < 0.1) return ENCODING_GB18030;
+        return ENCODING_UNKNOWN;
+    }
+
+    // תdataǰsizeֽڲ׷ӵoutʱlimit
+    static bool TranscodeRange(const char* data, size_t size, size_t limit, TextEncoding from, TextEncoding to,
+        std::string& out, TranscodePolicy policy, size_t* error_pos)
+    {
+        size_t old_size = out.size();
+        size_t n;
+        if (from == to || from == ENCODING_ASCII)
+        {
+            out.append(data, size);
+            return true;
+        }
+        else if (from == ENCODING_GB18030)
+        {
+            out.resize(old_size + size * 3);
+            n = size == 0 ? 0 : GB18030ToUTF8Range(data, size, limit, &out[old_size], policy, error_pos);
+        }
+        else
+        {
+            out.resize(old_size + size * 4);
+            n = size == 0 ? 0 : UTF8ToGB18030(data, size, &out[old_size], policy, error_pos);
+        }
+        if (n == TRANSCODE_ERROR)
+        {
+            out.resize(old_size);
+            return false;
+        }
+        out.resize(old_size + n);
+        return true;
+    }
+
+    static bool CheckTranscodeEncodings(const char* data, size_t size, TextEncoding& from, TextEncoding to)
+    {
+        if (to != ENCODING_UTF8 && to != ENCODING_GB18030) return false;
+        if (from == ENCODING_UNKNOWN) from = DetectEncoding(data, size);
+        return from != ENCODING_UNKNOWN;
+    }
+
+    bool Transcode(const char* data, size_t size, TextEncoding from, TextEncoding to, std::string& out,
+        TranscodePolicy policy, size_t* error_pos)
+    {
+        if (!CheckTranscodeEncodings(data, size, from, to)) return false;
+        return TranscodeRange(data, size, size, from, to, out, policy, error_pos);
+    }
+
+    static const size_t MIN_TRANSCODE_CHUNK = 1 << 20;
+
+    // зUTF-8GB18030ĶֽУ׶뵽֮󼴿ɱ֤תͬ
+    // ܳһûлʱз
+    static bool ParallelTranscodeRange(const char* data, size_t size, size_t limit, TextEncoding from, TextEncoding to,
+        std::string& out, TranscodePolicy policy, size_t* error_pos, int thread_num)
+    {
+        size_t chunk_num = std::min<size_t>(thread_num, size / MIN_TRANSCODE_CHUNK + 1);
+        if (chunk_num <= 1 || from == to || from == ENCODING_ASCII)
+        {
+            return TranscodeRange(data, size, limit, from, to, out, policy, error_pos);
+        }
+
+        std::vector<size_t> starts(chunk_num + 1, size);
+        starts[0] = 0;
+        for (size_t i = 1; i < chunk_num; ++i)
+        {
+            size_t pos = std::max(size / chunk_num * i, starts[i - 1]);
+            const char* line_end = static_cast<const char*>(memchr(data + pos, '\n', size - pos));
+            starts[i] = line_end ? line_end - data + 1 : size;
+        }
+
+        std::vector<std::string> results(chunk_num);
+        std::vector<size_t> errors(chunk_num, TRANSCODE_ERROR);
+        std::vector<std::thread*> thread_list;
+        for (size_t i = 0; i < chunk_num; ++i)
+        {
+            thread_list.push_back(new std::thread([&, i]() {
+                size_t pos = 0;
+                if (!TranscodeRange(data + starts[i], starts[i + 1] - starts[i], limit - starts[i],
+                    from, to, results[i], policy, &pos))
+                {
+                    errors[i] = starts[i] + pos;
+                }
+            }));
+        }
+        for (size_t i = 0; i < thread_list.size(); ++i)
+        {
+            thread_list[i]->join();
+            delete thread_list[i];
+        }
+
+        size_t total = 0;
+        for (size_t i = 0; i < chunk_num; ++i)
+        {
+            if (errors[i] != TRANSCODE_ERROR)
+            {
+                if (error_pos) *error_pos = errors[i];
+                return false;
+            }
+            total += results[i].size();
+        }
+        out.reserve(out.size() + total);
+        for (size_t i = 0; i < chunk_num; ++i)
+        {
+            out += results[i];
+        }
+        return true;
+    }
+
+    static int TranscodeThreadNum(int thread_num)
+    {
+        return thread_num > 0 ? thread_num : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    bool ParallelTranscode(const char* data, size_t size, TextEncoding from, TextEncoding to, std::string& out,
+        TranscodePolicy policy, size_t* error_pos, int thread_num)
+    {
+        if (!CheckTranscodeEncodings(data, size, from, to)) return false;
+        return ParallelTranscodeRange(data, size, size, from, to, out, policy, error_pos, TranscodeThreadNum(thread_num));
+    }
+
+    bool TranscodeFile(const std::string& src_path, const std::string& dst_path, TextEncoding to, TextEncoding from,
+        TranscodePolicy policy, int thread_num)
+    {
+        FILE* src = fopen(src_path.c_str(), "rb");
+        if (src == NULL) return false;
+        FILE* dst = fopen(dst_path.c_str(), "wb");
+        if (dst == NULL)
+        {
+            fclose(src);
+            return false;
+        }
+
+        thread_num = TranscodeThreadNum(thread_num);
+        // ÿ֤ÿ߳ٷֵһС
+        const size_t batch_size = MIN_TRANSCODE_CHUNK * 4 * thread_num;
+        std::string buffer, out;
+        bool ok = true, eof = false;
+        while (ok && !eof)
+        {
+            size_t old_size = buffer.size();
+            buffer.resize(old_size + batch_size);
+            size_t n = fread(&buffer[old_size], 1, batch_size, src);
+            buffer.resize(old_size + n);
+            eof = n < batch_size;
+            // ASCIIֱӸƣμ
+            TextEncoding batch_from = from;
+            if (!CheckTranscodeEncodings(buffer.data(), buffer.size(), batch_from, to))
+            {
+                ok = false;
+                break;
+            }
+            if (batch_from != ENCODING_ASCII) from = batch_from;
+
+            // δļĩβʱֻһΪֹһ֮һֽڣ
+            // ֤βĽضжתһ£ʣಿһ
+            size_t size = buffer.size();
+            if (!eof)
+            {
+                size = 0;
+                for (size_t pos = buffer.size() - 1; pos > 0; --pos)
+                {
+                    if (buffer[pos - 1] == '\n')
+                    {
+                        size = pos;
+                        break;
+                    }
+                }
+                if (size == 0) continue;
+            }
+
+            out.clear();
+            ok = ParallelTranscodeRange(buffer.data(), size, buffer.size(), batch_from, to, out, policy, NULL, thread_num) &&
+                fwrite(out.data(), 1, out.size(), dst) == out.size();
+            buffer.erase(0, size);
+        }
+        ok = !ferror(src) && ok;
+        fclose(src);
+        ok = fclose(dst) == 0 && ok;
+        if (!ok) remove(dst_path.c_str());
+        return ok;
+    }
+
+    bool isInt(const std::string & str)
+    {
+        int64_t value;
+        return ParseInt64(str, value);
+    }
+
+    bool isFloat(const std::string & str)
+    {
+        double value;
+        return ParseDouble(str, value);
+    }
+
+    bool isBool(const std::string & str)
+    {
+        bool value;
+        return ParseBool(str, value);
+    }
+
+    // ConvertFromStringػstringstreamһͷĿհײ'+'
+    static const char* SkipLeadingSpace(const std::string & s, const char*& last)
+    {
+        const char* p = s.c_str();
+        last = p + s.size();
+        while (p < last && isspace(static_cast<unsigned char>(*p))) ++p;
+        if (p < last && *p == '+' && !(p + 1 < last && p[1] == '-')) ++p;
+        return p;
+    }
+
+    template <typename T>
+    static T ConvertSignedFromString(const std::string & s)
+    {
+        const char* last;
+        const char* p = SkipLeadingSpace(s, last);
+        int64_t value = 0;
+        if (FromChars(p, last, value).ec == PARSE_INVALID) return 0;
+        if (value > static_cast<int64_t>(std::numeric_limits<T>::max())) return std::numeric_limits<T>::max();
+        if (value < static_cast<int64_t>(std::numeric_limits<T>::min())) return std::numeric_limits<T>::min();
+        return static_cast<T>(value);
+    }
+
+    template <typename T>
+    static T ConvertUnsignedFromString(const std::string & s)
+    {
+        const char* last;
+        const char* p = SkipLeadingSpace(s, last);
+        uint64_t value = 0;
+        if (FromChars(p, last, value).ec == PARSE_INVALID) return 0;
+        if (value > static_cast<uint64_t>(std::numeric_limits<T>::max())) return std::numeric_limits<T>::max();
+        return static_cast<T>(value);
+    }
+
+    template <typename T>
+    static T ConvertFloatFromString(const std::string & s)
+    {
+        const char* last;
+        const char* p = SkipLeadingSpace(s, last);
+        double value = 0;
+        FromCharsResult res = FromChars(p, last, value);
+        if (res.ec == PARSE_INVALID) return 0;
+        const double max_value = std::numeric_limits<T>::max();
+        if ((res.ec == PARSE_OUT_OF_RANGE && value != 0) || (value == value && fabs(value) > max_value && fabs(value) != HUGE_VAL))
+        {
+            return static_cast<T>(value < 0 ? -max_value : max_value);
+        }
+        return static_cast<T>(value);
+    }
+
+    template <> int ConvertFromString<int>(const std::string & s) { return ConvertSignedFromString<int>(s); }
+    template <> long ConvertFromString<long>(const std::string & s) { return ConvertSignedFromString<long>(s); }
+    template <> long long ConvertFromString<long long>(const std::string & s) { return ConvertSignedFromString<long long>(s); }
+    template <> unsigned int ConvertFromString<unsigned int>(const std::string & s) { return ConvertUnsignedFromString<unsigned int>(s); }
+    template <> unsigned long ConvertFromString<unsigned long>(const std::string & s) { return ConvertUnsignedFromString<unsigned long>(s); }
+    template <> unsigned long long ConvertFromString<unsigned long long>(const std::string & s) { return ConvertUnsignedFromString<unsigned long long>(s); }
+    template <> float ConvertFromString<float>(const std::string & s) { return ConvertFloatFromString<float>(s); }
+    template <> double ConvertFromString<double>(const std::string & s) { return ConvertFloatFromString<double>(s); }
+
+    template <> bool ConvertFromString<bool>(const std::string & s)
+    {
+        bool value = false;
+        if (!ParseBool(s, value))
+        {
+            value = ConvertSignedFromString<long long>(s) != 0;
+        }
+        return value;
+    }
+
+    static std::string FixedToString(double value)
+    {
+        char buffer[64];
+        int len = snprintf(buffer, sizeof(buffer), "%.6f", value);
+        std::string res;
+        if (len < static_cast<int>(sizeof(buffer)))
+        {
+            res.assign(buffer, len);
+        }
+        else
+        {
+            res.resize(len + 1);
+            snprintf(&res[0], res.size(), "%.6f", value);
+            res.resize(len);
+        }
+        // ʹlocaleеС
+        for (size_t i = 0; i < res.size(); ++i)
+        {
+            char c = res[i];
+            if ((c < '0' || c > '9') && c != '-' && (c < 'a' || c > 'z'))
+            {
+                res[i] = '.';
+            }
+        }
+        return res;
+    }
+
+    template <> std::string ConvertToString<int>(const int & s)
+    {
+        char buffer[32];
+        return std::string(buffer, FormatInt64(s, buffer));
+    }
+
+    template <> std::string ConvertToString<long>(const long & s)
+    {
+        char buffer[32];
+        return std::string(buffer, FormatInt64(s, buffer));
+    }
+
+    template <> std::string ConvertToString<long long>(const long long & s)
+    {
+        char buffer[32];
+        return std::string(buffer, FormatInt64(s, buffer));
+    }
+
+    template <> std::string ConvertToString<unsigned int>(const unsigned int & s)
+    {
+        char buffer[32];
+        return std::string(buffer, FormatUInt64(s, buffer));
+    }
+
+    template <> std::string ConvertToString<unsigned long>(const unsigned long & s)
+    {
+        char buffer[32];
+        return std::string(buffer, FormatUInt64(s, buffer));
+    }
+
+    template <> std::string ConvertToString<unsigned long long>(const unsigned long long & s)
+    {
+        char buffer[32];
+        return std::string(buffer, FormatUInt64(s, buffer));
+    }
+
+    template <> std::string ConvertToString<float>(const float & s)
+    {
+        return FixedToString(s);
+    }
+
+    template <> std::string ConvertToString<double>(const double & s)
+    {
+        return FixedToString(s);
+    }
+
+    template <> std::string ConvertToString<bool>(const bool & s)
+    {
+        return s ? "1" : "0";
+    }
+
+    // ȥ˵ĿոƱ
+    static StringView TrimBlank(const StringView& str)
+    {
+        const char* begin = str.begin();
+        const char* end = str.end();
+        while (begin < end && (*begin == ' ' || *begin == '\t')) ++begin;
+        while (end > begin && (*(end - 1) == ' ' || *(end - 1) == '\t')) --end;
+        return StringView(begin, end - begin);
+    }
+
+    // ۼʮֱ֣limitʱֻ¼
+    static const char* ParseDecimal(const char* p, const char* last, uint64_t limit, uint64_t& magnitude, bool& overflow)
+    {
+        magnitude = 0;
+        overflow = false;
+        for (; p < last; ++p)
+        {
+            unsigned digit = static_cast<unsigned char>(*p) - '0';
+            if (digit > 9) break;
+            if (overflow) continue;
+            if (magnitude > (limit - digit) / 10)
+                overflow = true;
+            else
+                magnitude = magnitude * 10 + digit;
+        }
+        return p;
+    }
+
+    FromCharsResult FromChars(const char* first, const char* last, int64_t& value)
+    {
+        FromCharsResult res = { first, PARSE_INVALID };
+        const char* p = first;
+        bool negative = p < last && *p == '-';
+        if (negative) ++p;
+        uint64_t magnitude;
+        bool overflow;
+        const char* end = ParseDecimal(p, last, negative ? static_cast<uint64_t>(INT64_MAX) + 1 : INT64_MAX,
+            magnitude, overflow);
+        if (end == p) return res;
+        res.ptr = end;
+        if (overflow)
+        {
+            res.ec = PARSE_OUT_OF_RANGE;
+            value = negative ? INT64_MIN : INT64_MAX;
+            return res;
+        }
+        res.ec = PARSE_OK;
+        value = negative ? (magnitude == 0 ? 0 : -static_cast<int64_t>(magnitude - 1) - 1) : static_cast<int64_t>(magnitude);
+        return res;
+    }
+
+    FromCharsResult FromChars(const char* first, const char* last, uint64_t& value)
+    {
+        FromCharsResult res = { first, PARSE_INVALID };
+        uint64_t magnitude;
+        bool overflow;
+        const char* end = ParseDecimal(first, last, UINT64_MAX, magnitude, overflow);
+        if (end == first) return res;
+        res.ptr = end;
+        res.ec = overflow ? PARSE_OUT_OF_RANGE : PARSE_OK;
+        value = overflow ? UINT64_MAX : magnitude;
+        return res;
+    }
+
+    // ִСдƥСдؼ֣ƥʱعؼ֮λ
+    static const char* MatchKeyword(const char* p, const char* last, const char* keyword)
+    {
+        for (; *keyword; ++p, ++keyword)
+        {
+            if (p == last || (*p | 0x20) != *keyword) return NULL;
+        }
+        return p;
+    }
+
+    // ·ʹù̶C localesetlocaleӰ
+    static double StrtodC(const char* str, char** end)
+    {
+#ifdef WIN32
+        static _locale_t c_locale = _create_locale(LC_NUMERIC, "C");
+        return _strtod_l(str, end, c_locale);
+#else
+        static locale_t c_locale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+        return strtod_l(str, end, c_locale);
+#endif
+    }
+
+    FromCharsResult FromChars(const char* first, const char* last, double& value)
+    {
+        static const double POW10[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        FromCharsResult res = { first, PARSE_INVALID };
+        const char* p = first;
+        bool negative = p < last && *p == '-';
+        if (negative) ++p;
+
+        const char* keyword_end = MatchKeyword(p, last, "inf");
+        if (keyword_end != NULL)
+        {
+            const char* long_end = MatchKeyword(keyword_end, last, "inity");
+            res.ptr = long_end ? long_end : keyword_end;
+            res.ec = PARSE_OK;
+            value = negative ? -HUGE_VAL : HUGE_VAL;
+            return res;
+        }
+        keyword_end = MatchKeyword(p, last, "nan");
+        if (keyword_end != NULL)
+        {
+            res.ptr = keyword_end;
+            res.ec = PARSE_OK;
+            value = negative ? -NAN : NAN;
+            return res;
+        }
+
+        // Чֲ19λ10ָ22ʱβ10ݶܾȷʾ
+        // һγ˳õľȷĽstrtod
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool has_digit = false;
+        for (; p < last && *p >= '0' && *p <= '9'; ++p)
+        {
+            has_digit = true;
+            if (mantissa == 0 && *p == '0') continue;
+            if (digits < 19) mantissa = mantissa * 10 + (*p - '0');
+            else ++exponent;
+            ++digits;
+        }
+        if (p < last && *p == '.')
+        {
+            for (++p; p < last && *p >= '0' && *p <= '9'; ++p)
+            {
+                has_digit = true;
+                if (mantissa == 0 && *p == '0')
+                {
+                    --exponent;
+                    continue;
+                }
+                if (digits < 19)
+                {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    --exponent;
+                }
+                ++digits;
+            }
+        }
+        if (!has_digit) return res;
+        // ֲָʱֵ
+        if (p < last && (*p == 'e' || *p == 'E'))
+        {
+            const char* q = p + 1;
+            bool exp_negative = false;
+            if (q < last && (*q == '-' || *q == '+'))
+            {
+                exp_negative = *q == '-';
+                ++q;
+            }
+            if (q < last && *q >= '0' && *q <= '9')
+            {
+                int exp_value = 0;
+                for (; q < last && *q >= '0' && *q <= '9'; ++q)
+                {
+                    if (exp_value < 100000) exp_value = exp_value * 10 + (*q - '0');
+                }
+                exponent += exp_negative ? -exp_value : exp_value;
+                p = q;
+            }
+        }
+        res.ptr = p;
+        res.ec = PARSE_OK;
+        if (mantissa == 0)
+        {
+            value = negative ? -0.0 : 0.0;
+            return res;
+        }
+        if (digits <= 19 && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+        {
+            double result = static_cast<double>(mantissa);
+            result = exponent < 0 ? result / POW10[-exponent] : result * POW10[exponent];
+            value = negative ? -result : result;
+            return res;
+        }
+
+        // ··Χֵ
+        char buffer[64];
+        std::string long_str;
+        const char* c_str = buffer;
+        size_t size = p - first;
+        if (size < sizeof(buffer))
+        {
+            memcpy(buffer, first, size);
+            buffer[size] = '\0';
+        }
+        else
+        {
+            long_str.assign(first, size);
+            c_str = long_str.c_str();
+        }
+        errno = 0;
+        double result = StrtodC(c_str, NULL);
+        // ǹҲERANGEֻ絽0㳬Χ
+        if (errno == ERANGE && (result == 0 || result == HUGE_VAL || result == -HUGE_VAL))
+        {
+            res.ec = PARSE_OUT_OF_RANGE;
+        }
+        value = result;
+        return res;
+    }
+
+    // ȥ˿հ׺ͷ'+''+'֮'-'
+    static bool PrepareParse(const StringView& str, const char*& first, const char*& last)
+    {
+        StringView s = TrimBlank(str);
+        first = s.begin();
+        last = s.end();
+        if (first < last && *first == '+')
+        {
+            ++first;
+            if (first < last && *first == '-') return false;
+        }
+        return true;
+    }
+
+    bool ParseInt64(const StringView& str, int64_t& value)
+    {
+        const char* first;
+        const char* last;
+        int64_t result;
+        if (!PrepareParse(str, first, last)) return false;
+        FromCharsResult res = FromChars(first, last, result);
+        if (res.ec != PARSE_OK || res.ptr != last) return false;
+        value = result;
+        return true;
+    }
+
+    bool ParseUInt64(const StringView& str, uint64_t& value)
+    {
+        const char* first;
+        const char* last;
+        uint64_t result;
+        if (!PrepareParse(str, first, last)) return false;
+        FromCharsResult res = FromChars(first, last, result);
+        if (res.ec != PARSE_OK || res.ptr != last) return false;
+        value = result;
+        return true;
+    }
+
+    bool ParseDouble(const StringView& str, double& value)
+    {
+        const char* first;
+        const char* last;
+        double result;
+        if (!PrepareParse(str, first, last)) return false;
+        FromCharsResult res = FromChars(first, last, result);
+        if (res.ec != PARSE_OK || res.ptr != last) return false;
+        value = result;
+        return true;
+    }
+
+    bool ParseBool(const StringView& str, bool& value)
+    {
+        StringView s = TrimBlank(str);
+        char lower[6] = {0};
+        if (s.empty() || s.size() > 5)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < s.size(); ++i)
+        {
+            lower[i] = static_cast<char>(tolower(static_cast<unsigned char>(s[i])));
+        }
+        if (!strcmp(lower, "true") || !strcmp(lower, "yes") || !strcmp(lower, "on") || !strcmp(lower, "1"))
+        {
+            value = true;
+            return true;
+        }
+        if (!strcmp(lower, "false") || !strcmp(lower, "no") || !strcmp(lower, "off") || !strcmp(lower, "0"))
+        {
+            value = false;
+            return true;
+        }
+        return false;
+    }
+
+    size_t FormatUInt64(uint64_t value, char* buffer)
+    {
+        static const char DIGITS[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+        char temp[24];
+        char* p = temp + sizeof(temp);
+        while (value >= 100)
+        {
+            unsigned index = (value % 100) * 2;
+            value /= 100;
+            *--p = DIGITS[index + 1];
+            *--p = DIGITS[index];
+        }
+        if (value >= 10)
+        {
+            unsigned index = value * 2;
+            *--p = DIGITS[index + 1];
+            *--p = DIGITS[index];
+        }
+        else
+        {
+            *--p = static_cast<char>('0' + value);
+        }
+        size_t len = temp + sizeof(temp) - p;
+        memcpy(buffer, p, len);
+        buffer[len] = '\0';
+        return len;
+    }
+
+    size_t FormatInt64(int64_t value, char* buffer)
+    {
+        if (value < 0)
+        {
+            *buffer = '-';
+            return FormatUInt64(0 - static_cast<uint64_t>(value), buffer + 1) + 1;
+        }
+        return FormatUInt64(value, buffer);
+    }
+
+    size_t FormatDouble(double value, char* buffer)
+    {
+        if (value != value)
+        {
+            memcpy(buffer, "nan", 4);
+            return 3;
+        }
+        if (value == HUGE_VAL || value == -HUGE_VAL)
+        {
+            memcpy(buffer, value < 0 ? "-inf" : "inf", value < 0 ? 5 : 4);
+            return value < 0 ? 4 : 3;
+        }
+        // 2^53ֱӰ
+        if (value <= 9007199254740992.0 && value >= -9007199254740992.0 &&
+            value == static_cast<double>(static_cast<int64_t>(value)))
+        {
+            if (value == 0 && 1 / value < 0)
+            {
+                memcpy(buffer, "-0", 3);
+                return 2;
+            }
+            return FormatInt64(static_cast<int64_t>(value), buffer);
+        }
+        // 15λЧֿʼԣܹԭʱΪ̱ʾ
+        int len = 0;
+        for (int precision = 15; precision <= 17; ++precision)
+        {
+            len = snprintf(buffer, 32, "%.*g", precision, value);
+            // ʹlocaleеС
+            for (int i = 0; i < len; ++i)
+            {
+                char c = buffer[i];
+                if ((c < '0' || c > '9') && c != '-' && c != '+' && c != 'e')
+                {
+                    buffer[i] = '.';
+                }
+            }
+            double parsed = 0;
+            if (precision == 17 || (ParseDouble(StringView(buffer, len), parsed) && parsed == value))
+            {
+                break;
+            }
+        }
+        return len;
+    }
+
+    static inline unsigned char AsciiLower(char ch)
+    {
+        unsigned char c = ch;
+        return static_cast<unsigned char>(c - 'A') < 26 ? c + ('a' - 'A') : c;
+    }
+
+    // ̰߳ȫı棬δʱfactory
+    template <typename Key, typename Value, typename Hash = std::hash<Key> >
+    class CompileCache
+    {
+    public:
+        template <typename Factory>
+        Value Get(const Key& key, Factory factory)
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex_);
+                typename Map::const_iterator it = _cache_.find(key);
+                if (it != _cache_.end()) return it->second;
+            }
+            // ⣬̵߳ĲңͬһģʽʱȲЧ
+            Value value = factory();
+            std::lock_guard<std::mutex> lock(_mutex_);
+            // ģʽͨǹ̶˵ö̬ģʽֱգȡĶӰ
+            if (_cache_.size() >= MAX_ENTRIES) _cache_.clear();
+            return _cache_.insert(std::make_pair(key, value)).first->second;
+        }
+
+        void Clear()
+        {
+            std::lock_guard<std::mutex> lock(_mutex_);
+            _cache_.clear();
+        }
+
+    private:
+        typedef std::unordered_map<Key, Value, Hash> Map;
+
+        static const size_t MAX_ENTRIES = 1024;
+        std::mutex _mutex_;
+        Map _cache_;
+    };
+
+    template <typename CharT>
+    struct RegexKeyHash
+    {
+        size_t operator()(const std::pair<std::basic_string<CharT>, unsigned int>& key) const
+        {
+            return std::hash<std::basic_string<CharT> >()(key.first) ^ (key.second * 0x9e3779b9U);
+        }
+    };
+
+    template <typename CharT>
+    struct RegexCache
+    {
+        typedef CompileCache<std::pair<std::basic_string<CharT>, unsigned int>,
+            std::shared_ptr<const std::basic_regex<CharT> >, RegexKeyHash<CharT> > Type;
+    };
+
+    template <typename CharT>
+    static typename RegexCache<CharT>::Type& GetRegexCache()
+    {
+        static typename RegexCache<CharT>::Type cache;
+        return cache;
+    }
+
+    template <typename CharT>
+    static std::shared_ptr<const std::basic_regex<CharT> > CompileCached(const std::basic_string<CharT>& reg_str, RegexFlags flags)
+    {
+        typedef std::basic_regex<CharT> Regex;
+        return GetRegexCache<CharT>().Get(std::make_pair(reg_str, static_cast<unsigned int>(flags)),
+            [&]() { return std::shared_ptr<const Regex>(new Regex(reg_str, flags)); });
+    }
+
+    // RegexSearch(str, reg_str)ִзģʽֻԶ
+    struct SearchPlan
+    {
+        RegexPtr regex;
+        std::shared_ptr<const MultiPatternMatcher> literal;
+    };
+
+    static CompileCache<std::string, SearchPlan>& GetSearchPlanCache()
+    {
+        static CompileCache<std::string, SearchPlan> cache;
+        return cache;
+    }
+
+    static SearchPlan GetSearchPlan(const std::string& reg_str)
+    {
+        return GetSearchPlanCache().Get(reg_str, [&]() {
+            SearchPlan plan;
+            std::vector<std::string> literals;
+            if (ParseLiteralPattern(reg_str, literals))
+                plan.literal.reset(new MultiPatternMatcher(literals));
+            else
+                plan.regex = CompileCached(reg_str, std::regex_constants::ECMAScript);
+            return plan;
+        });
+    }
+
+    RegexPtr CompileRegex(const std::string & reg_str, RegexFlags flags)
+    {
+        return CompileCached(reg_str, flags);
+    }
+
+    WRegexPtr CompileRegex(const std::wstring & wreg_str, RegexFlags flags)
+    {
+        return CompileCached(wreg_str, flags);
+    }
+
+    void ClearRegexCache()
+    {
+        GetRegexCache<char>().Clear();
+        GetRegexCache<wchar_t>().Clear();
+        GetSearchPlanCache().Clear();
+    }
+
+    static void ReportRegexError(const std::string & reg_str)
+    {
+        std::cerr << "regex error: " << reg_str << std::endl;
+    }
+
+    static void ReportRegexError(const std::wstring & wreg_str)
+    {
+        std::wcerr << "regex error: " << wreg_str << std::endl;
+    }
+
+    template <typename CharT>
+    static bool RegexFindGroups(const std::basic_string<CharT> & str, std::vector<std::basic_string<CharT> >& result,
+        const std::basic_regex<CharT> & pattern, bool whole)
+    {
+        std::match_results<typename std::basic_string<CharT>::const_iterator> mat;
+        bool found = whole ? std::regex_match(str, mat, pattern) : std::regex_search(str, mat, pattern);
+        if (found)
+        {
+            result.clear();
+            result.reserve(mat.size());
+            result.insert(result.begin(), mat.begin(), mat.end());
+        }
+        return found;
+    }
+
+    // ģʽַĽӿڣ룬ƥʱӡģʽfalse
+    template <typename CharT>
+    static bool RegexTest(const std::basic_string<CharT> & str, const std::basic_string<CharT> & reg_str, bool whole)
+    {
+        try
+        {
+            std::shared_ptr<const std::basic_regex<CharT> > pattern = CompileCached(reg_str, std::regex_constants::ECMAScript);
+            return whole ? std::regex_match(str, *pattern) : std::regex_search(str, *pattern);
+        }
+        catch (const std::exception&)
+        {
+            ReportRegexError(reg_str);
+            return false;
+        }
+    }
+
+    template <typename CharT>
+    static bool RegexTest(const std::basic_string<CharT> & str, std::vector<std::basic_string<CharT> >& result,
+        const std::basic_string<CharT> & reg_str, bool whole)
+    {
+        try
+        {
+            std::shared_ptr<const std::basic_regex<CharT> > pattern = CompileCached(reg_str, std::regex_constants::ECMAScript);
+            return RegexFindGroups(str, result, *pattern, whole);
+        }
+        catch (const std::exception&)
+        {
+            ReportRegexError(reg_str);
+            return false;
+        }
+    }
+
+    bool RegexSearch(const std::string & str, const std::string & reg_str)
+    {
+        try
+        {
+            SearchPlan plan = GetSearchPlan(reg_str);
+            return plan.literal ? plan.literal->Search(str) : std::regex_search(str, *plan.regex);
+        }
+        catch (const std::exception&)
+        {
+            ReportRegexError(reg_str);
+            return false;
+        }
     }
 
-    std::string SBC2DBC(const std::string & SBC)
+    bool RegexSearch(const std::wstring & wstr, const std::wstring & wreg_str)
+    {
+        return RegexTest(wstr, wreg_str, false);
+    }
+
+    bool RegexSearch(const std::string & str, std::vector<std::string>& result, const std::string & reg_str)
+    {
+        return RegexTest(str, result, reg_str, false);
+    }
+
+    bool RegexSearch(const std::wstring & wstr, std::vector<std::wstring>& result, const std::wstring & wreg_str)
+    {
+        return RegexTest(wstr, result, wreg_str, false);
+    }
+
+    bool RegexMatch(const std::string & str, const std::string & reg_str)
+    {
+        return RegexTest(str, reg_str, true);
+    }
+
+    bool RegexMatch(const std::wstring & wstr, const std::wstring & wreg_str)
+    {
+        return RegexTest(wstr, wreg_str, true);
+    }
+
+    bool RegexMatch(const std::string & str, std::vector<std::string>& result, const std::string & reg_str)
+    {
+        return RegexTest(str, result, reg_str, true);
+    }
+
+    bool RegexMatch(const std::wstring & wstr, std::vector<std::wstring>& result, const std::wstring & wreg_str)
+    {
+        return RegexTest(wstr, result, wreg_str, true);
+    }
+
+    std::string RegexReplace(const std::string & str, const std::string & reg_str, const std::string & sub_str)
+    {
+        return std::regex_replace(str, *CompileRegex(reg_str), sub_str);
+    }
+
+    std::wstring RegexReplace(const std::wstring & wstr, const std::wstring & wreg_str, const std::wstring & wsub_str)
+    {
+        return std::regex_replace(wstr, *CompileRegex(wreg_str), wsub_str);
+    }
+
+    bool RegexSearch(const std::string & str, const std::regex & pattern)
+    {
+        return std::regex_search(str, pattern);
+    }
+
+    bool RegexSearch(const std::wstring & wstr, const std::wregex & pattern)
+    {
+        return std::regex_search(wstr, pattern);
+    }
+
+    bool RegexSearch(const std::string & str, std::vector<std::string>& result, const std::regex & pattern)
+    {
+        return RegexFindGroups(str, result, pattern, false);
+    }
+
+    bool RegexSearch(const std::wstring & wstr, std::vector<std::wstring>& result, const std::wregex & pattern)
+    {
+        return RegexFindGroups(wstr, result, pattern, false);
+    }
+
+    bool RegexMatch(const std::string & str, const std::regex & pattern)
+    {
+        return std::regex_match(str, pattern);
+    }
+
+    bool RegexMatch(const std::wstring & wstr, const std::wregex & pattern)
+    {
+        return std::regex_match(wstr, pattern);
+    }
+
+    bool RegexMatch(const std::string & str, std::vector<std::string>& result, const std::regex & pattern)
+    {
+        return RegexFindGroups(str, result, pattern, true);
+    }
+
+    bool RegexMatch(const std::wstring & wstr, std::vector<std::wstring>& result, const std::wregex & pattern)
     {
-        int nCount = SBC.length();
+        return RegexFindGroups(wstr, result, pattern, true);
+    }
+
+    std::string RegexReplace(const std::string & str, const std::regex & pattern, const std::string & sub_str)
+    {
+        return std::regex_replace(str, pattern, sub_str);
+    }
 
-        unsigned char cTmp[2] = { 0, 0 }; // һֽڵڶֽ		
-        int nPos = 0;
+    std::wstring RegexReplace(const std::wstring & wstr, const std::wregex & pattern, const std::wstring & wsub_str)
+    {
+        return std::regex_replace(wstr, pattern, wsub_str);
+    }
 
-        char* pcResult = new char[nCount + 1]; // תַ,ȫǰҪһλ
+    template <typename CharT>
+    static size_t RegexTestAll(const std::vector<std::basic_string<CharT> >& inputs,
+        const std::basic_regex<CharT> & pattern, std::vector<bool>& matched, bool whole)
+    {
+        size_t count = 0;
+        matched.assign(inputs.size(), false);
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            bool found = whole ? std::regex_match(inputs[i], pattern) : std::regex_search(inputs[i], pattern);
+            if (found)
+            {
+                matched[i] = true;
+                ++count;
+            }
+        }
+        return count;
+    }
 
-        int nIndex = 0;
-        for (nIndex = 0;
-            nIndex < nCount - 1;    // һȡַԽ
-            nIndex += 2)            // Ƶһȫַ
+    template <typename CharT>
+    static void RegexReplaceEach(const std::vector<std::basic_string<CharT> >& inputs, const std::basic_regex<CharT> & pattern,
+        const std::basic_string<CharT> & sub_str, std::vector<std::basic_string<CharT> >& outputs)
+    {
+        outputs.resize(inputs.size());
+        for (size_t i = 0; i < inputs.size(); ++i)
         {
-            cTmp[0] = SBC[nIndex];      // ȡǰһֽ
-            cTmp[1] = SBC[nIndex + 1];  // ȡڶֽ	
+            // outputsеĻ
+            outputs[i].clear();
+            std::regex_replace(std::back_inserter(outputs[i]), inputs[i].begin(), inputs[i].end(), pattern, sub_str);
+        }
+    }
+
+    size_t RegexSearchAll(const std::vector<std::string>& inputs, const std::regex & pattern, std::vector<bool>& matched)
+    {
+        return RegexTestAll(inputs, pattern, matched, false);
+    }
+
+    size_t RegexSearchAll(const std::vector<std::wstring>& inputs, const std::wregex & pattern, std::vector<bool>& matched)
+    {
+        return RegexTestAll(inputs, pattern, matched, false);
+    }
+
+    size_t RegexMatchAll(const std::vector<std::string>& inputs, const std::regex & pattern, std::vector<bool>& matched)
+    {
+        return RegexTestAll(inputs, pattern, matched, true);
+    }
+
+    size_t RegexMatchAll(const std::vector<std::wstring>& inputs, const std::wregex & pattern, std::vector<bool>& matched)
+    {
+        return RegexTestAll(inputs, pattern, matched, true);
+    }
+
+    void RegexReplaceAll(const std::vector<std::string>& inputs, const std::regex & pattern,
+        const std::string & sub_str, std::vector<std::string>& outputs)
+    {
+        RegexReplaceEach(inputs, pattern, sub_str, outputs);
+    }
+
+    void RegexReplaceAll(const std::vector<std::wstring>& inputs, const std::wregex & pattern,
+        const std::wstring & wsub_str, std::vector<std::wstring>& outputs)
+    {
+        RegexReplaceEach(inputs, pattern, wsub_str, outputs);
+    }
+
+    MultiPatternMatcher::MultiPatternMatcher()
+    {
+        Build(std::vector<std::string>());
+    }
 
-            // ַ(33-126)ȫǵĶӦϵǣֽ0xA3ĩֽ128 
-            switch (GetCharClass(cTmp[0], cTmp[1])) // ȡ
+    MultiPatternMatcher::MultiPatternMatcher(const std::vector<std::string>& patterns, bool ignore_case)
+    {
+        Build(patterns, ignore_case);
+    }
+
+    void MultiPatternMatcher::Build(const std::vector<std::string>& patterns, bool ignore_case)
+    {
+        // ֻģʽгֹֽڷַ࣬תƱĿ֮С
+        memset(_classes_, 0, sizeof(_classes_));
+        _class_count_ = 1;
+        for (size_t i = 0; i < patterns.size(); ++i)
+        {
+            for (size_t j = 0; j < patterns[i].size(); ++j)
             {
-            case CC_SBCCHAR://ȫַ
+                unsigned char c = patterns[i][j];
+                if (ignore_case) c = AsciiLower(c);
+                if (_classes_[c] == 0) _classes_[c] = static_cast<uint16_t>(_class_count_++);
+            }
+        }
+        if (ignore_case)
+        {
+            for (int c = 'A'; c <= 'Z'; ++c) _classes_[c] = _classes_[c - 'A' + 'a'];
+        }
+
+        // ֵ-1ʾת
+        const size_t width = _class_count_;
+        _delta_.assign(width, -1);
+        std::vector<std::vector<int32_t> > outputs(1);
+        _lengths_.assign(patterns.size(), 0);
+        for (size_t i = 0; i < patterns.size(); ++i)
+        {
+            if (patterns[i].empty()) continue;
+            int32_t state = 0;
+            for (size_t j = 0; j < patterns[i].size(); ++j)
             {
-                if (cTmp[0] == 0xA3 && cTmp[1] == 0xA4/**/)
-                {
-                    pcResult[nPos++] = cTmp[0];
-                    pcResult[nPos++] = cTmp[1];
-                }
-                else if (cTmp[0] == 0xA3 && cTmp[1] >= 0xA1 && cTmp[1] < 0xFE)  // 33-126
-                {
-                    pcResult[nPos++] = cTmp[1] - 128;
-                }
-                //1.0.1 ⴦GB18030 һA1ȫ
-                else if (cTmp[0] == 0xA1 && cTmp[1] == 0xAA) // 
+                int32_t& next = _delta_[state * width + _classes_[static_cast<unsigned char>(patterns[i][j])]];
+                if (next < 0)
                 {
-                    pcResult[nPos++] = '-';
+                    next = static_cast<int32_t>(outputs.size());
+                    outputs.push_back(std::vector<int32_t>());
+                    _delta_.resize(_delta_.size() + width, -1);
                 }
-                else if (cTmp[0] == 0xA1 && cTmp[1] == 0xAB) //
+                state = _delta_[state * width + _classes_[static_cast<unsigned char>(patterns[i][j])]];
+            }
+            outputs[state].push_back(static_cast<int32_t>(i));
+            _lengths_[i] = patterns[i].size();
+        }
+
+        // αȫתƱȱʧתȡʧ״̬ת
+        const size_t state_count = outputs.size();
+        std::vector<int32_t> fail(state_count, 0);
+        _first_out_.assign(state_count, -1);
+        _dict_.assign(state_count, -1);
+        std::vector<int32_t> queue;
+        queue.reserve(state_count);
+        for (size_t c = 0; c < width; ++c)
+        {
+            int32_t& next = _delta_[c];
+            if (next < 0)
+                next = 0;
+            else
+                queue.push_back(next);
+        }
+        for (size_t head = 0; head < queue.size(); ++head)
+        {
+            int32_t state = queue[head];
+            int32_t link = fail[state];
+            // ʧ״̬ȸСʱѾ
+            _dict_[state] = _first_out_[link];
+            _first_out_[state] = outputs[state].empty() ? _dict_[state] : state;
+            for (size_t c = 0; c < width; ++c)
+            {
+                int32_t& next = _delta_[state * width + c];
+                if (next < 0)
                 {
-                    pcResult[nPos++] = '~';
+                    next = _delta_[link * width + c];
                 }
-                else if (cTmp[0] == 0xA1)
+                else
                 {
-                    switch (cTmp[1])
-                    {
-                    case 0xAA: pcResult[nPos++] = '-'; break;
-                    case 0xAB: pcResult[nPos++] = '~'; break;
-                    case 0xA3: pcResult[nPos++] = '.'; break;
-                    case 0xAE: pcResult[nPos++] = '\''; break;
-                    case 0xAF: pcResult[nPos++] = '\''; break;
-                    case 0xB0: pcResult[nPos++] = '"'; break;
-                    case 0xB1: pcResult[nPos++] = '"'; break;
-                    case 0xE7: pcResult[nPos++] = '$'; break;
-                    default: // ޶ӦǵĲ
-                    {
-                        pcResult[nPos++] = cTmp[0];
-                        pcResult[nPos++] = cTmp[1];
-                    }
-                    }
+                    fail[next] = _delta_[link * width + c];
+                    queue.push_back(next);
                 }
-                //////////////////////////////////////////////////////////////////////////
-                else // ޶ӦǵĲ
+            }
+        }
+
+        _out_begin_.assign(state_count + 1, 0);
+        _out_.clear();
+        for (size_t i = 0; i < state_count; ++i)
+        {
+            _out_begin_[i] = static_cast<int32_t>(_out_.size());
+            _out_.insert(_out_.end(), outputs[i].begin(), outputs[i].end());
+        }
+        _out_begin_[state_count] = static_cast<int32_t>(_out_.size());
+    }
+
+    bool MultiPatternMatcher::Search(const StringView& text) const
+    {
+        int32_t state = 0;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            state = Next(state, text[i]);
+            if (_first_out_[state] >= 0) return true;
+        }
+        return false;
+    }
+
+    size_t MultiPatternMatcher::FindAll(const StringView& text, std::vector<PatternMatch>& matches) const
+    {
+        matches.clear();
+        int32_t state = 0;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            state = Next(state, text[i]);
+            for (int32_t out = _first_out_[state]; out >= 0; out = _dict_[out])
+            {
+                for (int32_t k = _out_begin_[out]; k < _out_begin_[out + 1]; ++k)
                 {
-                    pcResult[nPos++] = cTmp[0];
-                    pcResult[nPos++] = cTmp[1];
+                    PatternMatch match;
+                    match.pattern = _out_[k];
+                    match.length = _lengths_[match.pattern];
+                    match.offset = i + 1 - match.length;
+                    matches.push_back(match);
                 }
-                break;
             }
-            case CC_SBCSPACE:   // ȫǿո
-                pcResult[nPos++] = ' ';
-                break;
-            case CC_SBCCHINESE://
+        }
+        return matches.size();
+    }
+
+    bool ParseLiteralPattern(const std::string & reg_str, std::vector<std::string>& literals)
+    {
+        literals.clear();
+        std::string current;
+        for (size_t i = 0; i < reg_str.size(); ++i)
+        {
+            char c = reg_str[i];
+            if (c == '\\')
+            {
+                // \d\b\n\x41ת嶼⺬壬ֻתı
+                if (i + 1 == reg_str.size() || isalnum(static_cast<unsigned char>(reg_str[i + 1])))
+                    return false;
+                current += reg_str[++i];
+            }
+            else if (c == '|')
+            {
+                // ѡ֧ƥմ
+                if (current.empty()) return false;
+                literals.push_back(current);
+                current.clear();
+            }
+            else if (strchr(".^$*+?()[]{}", c) != NULL)
             {
-                pcResult[nPos++] = cTmp[0];
-                pcResult[nPos++] = cTmp[1];
+                return false;
             }
-            break;
-            case CC_DBCCHAR:    // ַ			
-            case CC_DBCSPACE:   // ǿո
+            else
             {
-                pcResult[nPos++] = cTmp[0];
-                nIndex--;   // ֻһַ
+                current += c;
             }
-            break;
-            default:
-                pcResult[nPos++] = cTmp[0];
-                pcResult[nPos++] = cTmp[1];
+        }
+        if (current.empty()) return false;
+        literals.push_back(current);
+        return true;
+    }
+
+    bool RegexSearch(const std::string & str, const MultiPatternMatcher & matcher)
+    {
+        return matcher.Search(str);
+    }
+
+    bool RegexSearch(const std::string & str, std::vector<PatternMatch>& matches, const MultiPatternMatcher & matcher)
+    {
+        return matcher.FindAll(str, matches) > 0;
+    }
+
+    // [first, first+26)ڵֽڼdeltaֽڲ
+    static void ShiftCase(const char* src, size_t size, char* dst, char first, char delta)
+    {
+        size_t i = 0;
+#if defined(__SSE2__)
+        // зűȽϣȰfirstƽƵ-128ڵֽھ[-128, -128+26)
+        const __m128i shift = _mm_set1_epi8(static_cast<char>(-128 - first));
+        const __m128i bound = _mm_set1_epi8(-128 + 26);
+        const __m128i add = _mm_set1_epi8(delta);
+        for (; i + 16 <= size; i += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128i in_range = _mm_cmplt_epi8(_mm_add_epi8(v, shift), bound);
+            v = _mm_add_epi8(v, _mm_and_si128(in_range, add));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+        }
+#endif
+        for (; i < size; ++i)
+        {
+            char c = src[i];
+            dst[i] = static_cast<unsigned char>(c - first) < 26 ? static_cast<char>(c + delta) : c;
+        }
+    }
+
+    void toLower(const char* src, size_t size, char* dst)
+    {
+        ShiftCase(src, size, dst, 'A', 'a' - 'A');
+    }
+
+    void toUpper(const char* src, size_t size, char* dst)
+    {
+        ShiftCase(src, size, dst, 'a', 'A' - 'a');
+    }
+
+    std::string toLower(const StringView& str)
+    {
+        std::string res(str.size(), '\0');
+        if (!str.empty()) toLower(str.data(), str.size(), &res[0]);
+        return res;
+    }
+
+    std::string toUpper(const StringView& str)
+    {
+        std::string res(str.size(), '\0');
+        if (!str.empty()) toUpper(str.data(), str.size(), &res[0]);
+        return res;
+    }
+
+    std::string& toLowerInplace(std::string& str)
+    {
+        if (!str.empty()) toLower(str.data(), str.size(), &str[0]);
+        return str;
+    }
+
+    std::string& toUpperInplace(std::string& str)
+    {
+        if (!str.empty()) toUpper(str.data(), str.size(), &str[0]);
+        return str;
+    }
+
+    int icompare(const StringView& a, const StringView& b)
+    {
+        size_t n = a.size() < b.size() ? a.size() : b.size();
+        for (size_t i = 0; i < n; ++i)
+        {
+            unsigned char ca = AsciiLower(a[i]);
+            unsigned char cb = AsciiLower(b[i]);
+            if (ca != cb) return ca < cb ? -1 : 1;
+        }
+        if (a.size() == b.size()) return 0;
+        return a.size() < b.size() ? -1 : 1;
+    }
+
+    size_t ihash(const StringView& str)
+    {
+        // FNV-1aСдֽڼ㣬֤iequalsȵĴϣֵͬ
+        uint64_t h = 14695981039346656037ULL;
+        for (size_t i = 0; i < str.size(); ++i)
+        {
+            h ^= AsciiLower(str[i]);
+            h *= 1099511628211ULL;
+        }
+        return static_cast<size_t>(h);
+    }
+
+    size_t StringViewHash::operator()(const StringView& str) const
+    {
+        uint64_t h = 14695981039346656037ULL;
+        for (size_t i = 0; i < str.size(); ++i)
+        {
+            h ^= static_cast<unsigned char>(str[i]);
+            h *= 1099511628211ULL;
+        }
+        return static_cast<size_t>(h);
+    }
+
+    // GB0xA10xA3ȫַӦİַ±Ϊڶֽ - 0xA10ʾת
+    struct GBHalfWidthTable
+    {
+        char row_a1[94];
+        char row_a3[94];
+        GBHalfWidthTable()
+        {
+            memset(row_a1, 0, sizeof(row_a1));
+            row_a1[0xA1 - 0xA1] = ' ';      // ȫǿո
+            row_a1[0xA3 - 0xA1] = '.';      // 
+            row_a1[0xAA - 0xA1] = '-';      // 
+            row_a1[0xAB - 0xA1] = '~';      // 
+            row_a1[0xAE - 0xA1] = '\'';     // 
+            row_a1[0xAF - 0xA1] = '\'';     // 
+            row_a1[0xB0 - 0xA1] = '"';      // 
+            row_a1[0xB1 - 0xA1] = '"';      // 
+            row_a1[0xE7 - 0xA1] = '$';      // 
+            // 0xA3ASCII 33~126ȫʽڶֽ128(A3A4)ͣ(A3FE)ûжӦİ
+            for (int c = 0xA1; c < 0xFE; ++c)
+            {
+                row_a3[c - 0xA1] = static_cast<char>(c - 0x80);
             }
-        } // end for (int nIndex = 0; nIndex < nCount - 1; nIndex++) //һδ
+            row_a3[0xA4 - 0xA1] = 0;
+            row_a3[0xFE - 0xA1] = 0;
+        }
+    };
 
-        if (nIndex == nCount - 1) // һǰַ,δ, һȫʱ i == nCount
+    size_t SBC2DBC(const char* src, size_t size, char* dst)
+    {
+        static const GBHalfWidthTable table;
+        const unsigned char* s = reinterpret_cast<const unsigned char*>(src);
+        size_t i = 0, n = 0;
+        while (i < size)
         {
-            pcResult[nPos++] = SBC[nIndex];
+            size_t ascii_end = SkipASCII(s, size, i);
+            while (ascii_end < size && s[ascii_end] < 0x80) ++ascii_end;
+            if (ascii_end > i)
+            {
+                if (dst + n != src + i) memmove(dst + n, src + i, ascii_end - i);
+                n += ascii_end - i;
+                i = ascii_end;
+                if (i == size) break;
+            }
+            // ASCIIֽڰ˫ֽڴֽ붼0xA10xA3еתΧ
+            if (i + 1 == size)
+            {
+                dst[n++] = src[i++];
+                break;
+            }
+            unsigned char c1 = s[i], c2 = s[i + 1];
+            char half = 0;
+            if (c2 >= 0xA1 && c2 <= 0xFE)
+            {
+                if (c1 == 0xA1) half = table.row_a1[c2 - 0xA1];
+                else if (c1 == 0xA3) half = table.row_a3[c2 - 0xA1];
+            }
+            if (half != 0)
+            {
+                dst[n++] = half;
+            }
+            else
+            {
+                dst[n++] = src[i];
+                dst[n++] = src[i + 1];
+            }
+            i += 2;
         }
+        return n;
+    }
+
+    std::string SBC2DBC(const std::string & SBC)
+    {
+        std::string res(SBC.size(), '\0');
+        if (!SBC.empty()) res.resize(SBC2DBC(SBC.data(), SBC.size(), &res[0]));
+        return res;
+    }
 
-        pcResult[nPos++] = 0;   // 0
+    std::string& SBC2DBCInplace(std::string& str)
+    {
+        if (!str.empty()) str.resize(SBC2DBC(str.data(), str.size(), &str[0]));
+        return str;
+    }
 
-        std::string strResult(pcResult);    // ת
+    // UTF-8U+FF01~U+FF5EΪEF BC 81~EF BC BFEF BD 80~EF BD 9EU+3000ΪE3 80 80
+    // 0xE30xEFֻΪֽڳֽ֣ڼı
+    size_t SBC2DBCUTF8(const char* src, size_t size, char* dst)
+    {
+        const unsigned char* s = reinterpret_cast<const unsigned char*>(src);
+        size_t i = 0, n = 0;
+        while (i < size)
+        {
+#if defined(__SSE2__)
+            const __m128i lead_e3 = _mm_set1_epi8(static_cast<char>(0xE3));
+            const __m128i lead_ef = _mm_set1_epi8(static_cast<char>(0xEF));
+            size_t skip = 0;
+            for (; i + skip + 16 <= size; skip += 16)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + skip));
+                int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, lead_e3), _mm_cmpeq_epi8(v, lead_ef)));
+                if (mask != 0)
+                {
+                    skip += __builtin_ctz(mask);
+                    break;
+                }
+            }
+            if (skip > 0)
+            {
+                if (dst + n != src + i) memmove(dst + n, src + i, skip);
+                n += skip;
+                i += skip;
+                if (i == size) break;
+            }
+#endif
+            unsigned char c = s[i];
+            if ((c == 0xEF || c == 0xE3) && i + 2 < size)
+            {
+                unsigned char c2 = s[i + 1], c3 = s[i + 2];
+                char half = 0;
+                if (c == 0xE3)
+                {
+                    if (c2 == 0x80 && c3 == 0x80) half = ' ';
+                }
+                else if (c2 == 0xBC && c3 >= 0x81 && c3 <= 0xBF)
+                {
+                    half = static_cast<char>(c3 - 0x60);
+                }
+                else if (c2 == 0xBD && c3 >= 0x80 && c3 <= 0x9E)
+                {
+                    half = static_cast<char>(c3 - 0x20);
+                }
+                if (half != 0)
+                {
+                    dst[n++] = half;
+                    i += 3;
+                    continue;
+                }
+            }
+            dst[n++] = src[i++];
+        }
+        return n;
+    }
 
-        delete[] pcResult;
+    std::string SBC2DBCUTF8(const StringView& sbc)
+    {
+        std::string res(sbc.size(), '\0');
+        if (!sbc.empty()) res.resize(SBC2DBCUTF8(sbc.data(), sbc.size(), &res[0]));
+        return res;
+    }
 
-        return strResult;
+    std::string& SBC2DBCUTF8Inplace(std::string& str)
+    {
+        if (!str.empty()) str.resize(SBC2DBCUTF8(str.data(), str.size(), &str[0]));
+        return str;
     }
 
 }
@@ -7,10 +7,102 @@
 #include <vector>
 #include <locale>
 #include <codecvt>
+#include <cstring>
+#include <stdint.h>
+#include <regex>
+#include <memory>
 
 namespace htk
 {
 
+    /* ַֻͼڴ棬ʹҪ֤ײݵ */
+    class StringView
+    {
+    public:
+        StringView() : _data_(NULL), _size_(0) {}
+        StringView(const char* data, size_t size) : _data_(data), _size_(size) {}
+        StringView(const char* str) : _data_(str), _size_(strlen(str)) {}
+        StringView(const std::string& str) : _data_(str.data()), _size_(str.size()) {}
+
+        const char* data() const { return _data_; }
+        size_t size() const { return _size_; }
+        size_t length() const { return _size_; }
+        bool empty() const { return _size_ == 0; }
+        const char* begin() const { return _data_; }
+        const char* end() const { return _data_ + _size_; }
+        char operator[](size_t pos) const { return _data_[pos]; }
+
+        StringView substr(size_t pos, size_t n = std::string::npos) const
+        {
+            if (pos > _size_) pos = _size_;
+            if (n > _size_ - pos) n = _size_ - pos;
+            return StringView(_data_ + pos, n);
+        }
+        std::string str() const { return std::string(_data_, _size_); }
+
+        // ַӴҲʱstd::string::npos
+        size_t find(char c, size_t pos = 0) const
+        {
+            if (pos >= _size_) return std::string::npos;
+            const void* p = memchr(_data_ + pos, c, _size_ - pos);
+            return p ? static_cast<const char*>(p) - _data_ : std::string::npos;
+        }
+        size_t find(const StringView& sub, size_t pos = 0) const
+        {
+            if (sub._size_ == 1) return find(sub._data_[0], pos);
+            if (pos > _size_ || sub._size_ > _size_ - pos) return std::string::npos;
+            if (sub._size_ == 0) return pos;
+            const char* last = _data_ + _size_ - sub._size_;
+            for (const char* p = _data_ + pos; p <= last; ++p)
+            {
+                p = static_cast<const char*>(memchr(p, sub._data_[0], last - p + 1));
+                if (p == NULL) break;
+                if (memcmp(p, sub._data_, sub._size_) == 0) return p - _data_;
+            }
+            return std::string::npos;
+        }
+
+        bool operator==(const StringView& other) const
+        {
+            return _size_ == other._size_ &&
+                (_size_ == 0 || memcmp(_data_, other._data_, _size_) == 0);
+        }
+        bool operator!=(const StringView& other) const { return !(*this == other); }
+
+    private:
+        const char* _data_;
+        size_t _size_;
+    };
+
+    /* ַϣ256λλͼʾڿжַǷڼ */
+    class CharSet
+    {
+    public:
+        CharSet() { memset(_bits_, 0, sizeof(_bits_)); }
+        CharSet(const StringView& chars)
+        {
+            memset(_bits_, 0, sizeof(_bits_));
+            for (size_t i = 0; i < chars.size(); ++i)
+            {
+                unsigned char c = chars[i];
+                _bits_[c >> 6] |= 1ULL << (c & 63);
+            }
+        }
+
+        bool contains(char ch) const
+        {
+            unsigned char c = ch;
+            return (_bits_[c >> 6] >> (c & 63)) & 1;
+        }
+        bool empty() const
+        {
+            return (_bits_[0] | _bits_[1] | _bits_[2] | _bits_[3]) == 0;
+        }
+
+    private:
+        uint64_t _bits_[4];
+    };
+
     /* ַƥ */
     inline bool startswith(const std::string& str, const std::string& head)
     {
@@ -48,11 +140,67 @@ namespace htk
 
     std::string join(const std::vector<std::string> vec, const std::string& delimiter);
 
+    /* ڴķָsplit/split_with_quotͬÿһָstrStringView
+     * tokensȱգڶε֮临Ա· */
+    size_t split_view(const StringView& str, const StringView& delimiter,
+        std::vector<StringView>& tokens, const StringView& trim_str = StringView());
+    size_t split_with_quot_view(const StringView& str, const char delimiter,
+        std::vector<StringView>& tokens, const char quot = '"', const StringView& trim_str = StringView());
+
+    /* ÿһcallback(StringView)callbackfalseʱֹͣȫ귵true
+     * splitͬмĿһָ֮Ŀ */
+    template<typename Callback>
+    bool for_each_token(const StringView& str, const StringView& delimiter, Callback callback)
+    {
+        if (delimiter.empty())
+        {
+            return str.empty() || callback(str);
+        }
+        size_t start = 0;
+        while (start < str.size())
+        {
+            size_t end = str.find(delimiter, start);
+            if (end == std::string::npos)
+            {
+                return callback(str.substr(start));
+            }
+            if (!callback(str.substr(start, end - start)))
+            {
+                return false;
+            }
+            start = end + delimiter.size();
+        }
+        return true;
+    }
+
     /* ַ */
     std::string trim_left(const std::string& str, const std::string& sub_str);
     std::string trim_right(const std::string& str, const std::string& sub_str);
     std::string trim(const std::string& str, const std::string& sub_str);
 
+    /* StringViewļãڴ棬ָstr */
+    inline StringView trim_left_view(const StringView& str, const CharSet& chars)
+    {
+        const char* begin = str.begin();
+        while (begin < str.end() && chars.contains(*begin)) ++begin;
+        return StringView(begin, str.end() - begin);
+    }
+    inline StringView trim_right_view(const StringView& str, const CharSet& chars)
+    {
+        const char* end = str.end();
+        while (end > str.begin() && chars.contains(*(end - 1))) --end;
+        return StringView(str.begin(), end - str.begin());
+    }
+    inline StringView trim_view(const StringView& str, const CharSet& chars)
+    {
+        return trim_right_view(trim_left_view(str, chars), chars);
+    }
+
+    /* ԭؼã޸Ĳstr */
+    std::string& trim_left_inplace(std::string& str, const CharSet& chars);
+    std::string& trim_right_inplace(std::string& str, const CharSet& chars);
+    std::string& trim_inplace(std::string& str, const CharSet& chars);
+
     /* ַת */
     std::wstring String2Wstring(const std::string & str, const char* encoding = "chs");
     std::string Wstring2String(const std::wstring & wstr, const char* encoding = "chs");
@@ -78,11 +226,111 @@ namespace htk
     std::string utf8_to_gb18030(const std::string& str);
     std::string gb18030_to_utf8(const std::string& str);
 
-    /* ַж TODO */
+    /* Unicodeת룬localeASCIIʹSIMD */
+    // ǷʱĴʽ
+    enum TranscodePolicy
+    {
+        TRANSCODE_REPLACE,  // 滻ΪU+FFFDÿķǷ滻һ
+        TRANSCODE_SKIP,     // ֱӶ
+        TRANSCODE_FAIL      // ֹͣתTRANSCODE_ERROR
+    };
+    const size_t TRANSCODE_ERROR = static_cast<size_t>(-1);
+
+    // УUTF-8ܾ롢ͳU+10FFFF㣻Ƿʱerror_pos׸Ƿеλ
+    bool IsValidUTF8(const char* data, size_t size, size_t* error_pos = NULL);
+
+    // д÷ĻдԪdstҪ
+    // UTF8ToUTF16UTF8ToUTF32ΪsizeUTF16ToUTF8Ϊ3*sizeUTF32ToUTF8Ϊ4*size
+    // TRANSCODE_FAIL᷵TRANSCODE_ERRORʱerror_posΪǷsrcеλ
+    size_t UTF8ToUTF16(const char* src, size_t size, char16_t* dst,
+        TranscodePolicy policy = TRANSCODE_REPLACE, size_t* error_pos = NULL);
+    size_t UTF8ToUTF32(const char* src, size_t size, char32_t* dst,
+        TranscodePolicy policy = TRANSCODE_REPLACE, size_t* error_pos = NULL);
+    size_t UTF16ToUTF8(const char16_t* src, size_t size, char* dst,
+        TranscodePolicy policy = TRANSCODE_REPLACE, size_t* error_pos = NULL);
+    size_t UTF32ToUTF8(const char32_t* src, size_t size, char* dst,
+        TranscodePolicy policy = TRANSCODE_REPLACE, size_t* error_pos = NULL);
+
+    // ׷ӵoutĩβɸoutеʧʱoutֲ䲢false
+    // wstringwchar_tĿΪUTF-16(Windows)UTF-32
+    bool AppendUTF8ToUTF16(const StringView& src, std::u16string& out, TranscodePolicy policy = TRANSCODE_REPLACE);
+    bool AppendUTF8ToUTF32(const StringView& src, std::u32string& out, TranscodePolicy policy = TRANSCODE_REPLACE);
+    bool AppendUTF8ToWide(const StringView& src, std::wstring& out, TranscodePolicy policy = TRANSCODE_REPLACE);
+    bool AppendUTF16ToUTF8(const std::u16string& src, std::string& out, TranscodePolicy policy = TRANSCODE_REPLACE);
+    bool AppendUTF32ToUTF8(const std::u32string& src, std::string& out, TranscodePolicy policy = TRANSCODE_REPLACE);
+    bool AppendWideToUTF8(const std::wstring& src, std::string& out, TranscodePolicy policy = TRANSCODE_REPLACE);
+
+    /* GB18030UTF-8תʹlocalḛ߳ȫGBKGB18030˫ֽڲֵӼ */
+    // dstҪGB18030ToUTF8Ϊ3*sizeUTF8ToGB18030Ϊ4*sizeֵǷеĴͬ
+    size_t GB18030ToUTF8(const char* src, size_t size, char* dst,
+        TranscodePolicy policy = TRANSCODE_REPLACE, size_t* error_pos = NULL);
+    size_t UTF8ToGB18030(const char* src, size_t size, char* dst,
+        TranscodePolicy policy = TRANSCODE_REPLACE, size_t* error_pos = NULL);
+    bool AppendGB18030ToUTF8(const StringView& src, std::string& out, TranscodePolicy policy = TRANSCODE_REPLACE);
+    bool AppendUTF8ToGB18030(const StringView& src, std::string& out, TranscodePolicy policy = TRANSCODE_REPLACE);
+
+    /* ת */
+    enum TextEncoding
+    {
+        ENCODING_UNKNOWN,
+        ENCODING_ASCII,
+        ENCODING_UTF8,
+        ENCODING_GB18030    // GBKGB2312
+    };
+
+    // 룺ݳsample_sizeʱڿͷмͽβֶȡ
+    // UTF-8GB18030ֱ룬ͳƷASCIIַǷеĸжϣͷUTF-8 BOMʱֱΪUTF-8
+    TextEncoding DetectEncoding(const char* data, size_t size, size_t sample_size = 64 * 1024);
+
+    // ת벢׷ӵoutfromΪENCODING_UNKNOWNʱԶ⣬fromtoͬΪASCIIʱֱӸƣ
+    // toֻENCODING_UTF8ENCODING_GB18030ʧʱoutֲ䣬error_posΪǷdataеλ
+    bool Transcode(const char* data, size_t size, TextEncoding from, TextEncoding to, std::string& out,
+        TranscodePolicy policy = TRANSCODE_REPLACE, size_t* error_pos = NULL);
+    // ڻдп߳ת룬Transcodeȫͬthread_num <= 0ʱʹȫ
+    bool ParallelTranscode(const char* data, size_t size, TextEncoding from, TextEncoding to, std::string& out,
+        TranscodePolicy policy = TRANSCODE_REPLACE, size_t* error_pos = NULL, int thread_num = 0);
+    // ļת룺룬ÿת˳дڴռļС޹أ
+    // fromΪENCODING_UNKNOWNʱݶݼ⣬ASCIIĲԭơʧʱɾĿļ
+    bool TranscodeFile(const std::string& src_path, const std::string& dst_path, TextEncoding to = ENCODING_UTF8,
+        TextEncoding from = ENCODING_UNKNOWN, TranscodePolicy policy = TRANSCODE_REPLACE, int thread_num = 0);
+
+    /* ַжϣͬParseInt64ParseDoubleParseBoolҲǺϷĸ */
     bool isInt(const std::string& str);
     bool isFloat(const std::string& str);
     bool isBool(const std::string& str);
 
+    /* from_charsֵհף'+'ţ[first, last)ܳǰ׺localeӰ */
+    enum ParseErrc
+    {
+        PARSE_OK,
+        PARSE_INVALID,          // ͷǺϷֵptrfirstvalue
+        PARSE_OUT_OF_RANGE      // Χptrֵָ֮valueΪֵ(strtollstrtodһ)
+    };
+    struct FromCharsResult
+    {
+        const char* ptr;
+        ParseErrc ec;
+    };
+    // ʮз'-'ͷ
+    FromCharsResult FromChars(const char* first, const char* last, int64_t& value);
+    FromCharsResult FromChars(const char* first, const char* last, uint64_t& value);
+    // [-][.][(e|E)[+|-]]ԼִСдinfinfinitynanȷ룻
+    // ʱvalueΪ0
+    FromCharsResult FromChars(const char* first, const char* last, double& value);
+
+    /* ֵڴ棬ַ(пո'+')ǺϷֵʱtrueʧʱvalue */
+    bool ParseInt64(const StringView& str, int64_t& value);
+    bool ParseUInt64(const StringView& str, uint64_t& value);
+    bool ParseDouble(const StringView& str, double& value);
+    // ֧true/falseyes/noon/off(ִСд)Լ1/0
+    bool ParseBool(const StringView& str, bool& value);
+
+    /* ֵʽڴ桢localeӰ죬buffer32ֽڣдĳ(β'\0') */
+    size_t FormatInt64(int64_t value, char* buffer);
+    size_t FormatUInt64(uint64_t value, char* buffer);
+    // ܹȷԭ̱ʾ
+    size_t FormatDouble(double value, char* buffer);
+
     /*  */
     bool RegexSearch(const std::string &str, const std::string &reg_str);
     bool RegexSearch(const std::wstring &wstr, const std::wstring &wreg_str);
@@ -97,9 +345,121 @@ namespace htk
     std::string RegexReplace(const std::string &str, const std::string &reg_str, const std::string &sub_str);
     std::wstring RegexReplace(const std::wstring &wstr, const std::wstring &wreg_str, const std::wstring &wsub_str);
 
-    /* Сдת */
-    std::string toLower(const std::string& str);
-    std::string toUpper(const std::string& str);
+    /* Ԥ򣬱ֻڶ̼߳乲 */
+    typedef std::shared_ptr<const std::regex> RegexPtr;
+    typedef std::shared_ptr<const std::wregex> WRegexPtr;
+    typedef std::regex_constants::syntax_option_type RegexFlags;
+
+    // ӽ̼лȡõ(ģʽ, flags)Ϊ̰߳ȫ
+    // ģʽǷʱ׳std::regex_errorϴģʽַĽӿھ˻
+    RegexPtr CompileRegex(const std::string &reg_str, RegexFlags flags = std::regex_constants::ECMAScript);
+    WRegexPtr CompileRegex(const std::wstring &wreg_str, RegexFlags flags = std::regex_constants::ECMAScript);
+    void ClearRegexCache();
+
+    bool RegexSearch(const std::string &str, const std::regex &pattern);
+    bool RegexSearch(const std::wstring &wstr, const std::wregex &pattern);
+    bool RegexSearch(const std::string &str, std::vector<std::string> &result, const std::regex &pattern);
+    bool RegexSearch(const std::wstring &wstr, std::vector<std::wstring> &result, const std::wregex &pattern);
+
+    bool RegexMatch(const std::string &str, const std::regex &pattern);
+    bool RegexMatch(const std::wstring &wstr, const std::wregex &pattern);
+    bool RegexMatch(const std::string &str, std::vector<std::string> &result, const std::regex &pattern);
+    bool RegexMatch(const std::wstring &wstr, std::vector<std::wstring> &result, const std::wregex &pattern);
+
+    std::string RegexReplace(const std::string &str, const std::regex &pattern, const std::string &sub_str);
+    std::wstring RegexReplace(const std::wstring &wstr, const std::wregex &pattern, const std::wstring &wsub_str);
+
+    // ӿڣÿӦͬһmatched[i]Ӧinputs[i]ƥĸ
+    size_t RegexSearchAll(const std::vector<std::string> &inputs, const std::regex &pattern, std::vector<bool> &matched);
+    size_t RegexSearchAll(const std::vector<std::wstring> &inputs, const std::wregex &pattern, std::vector<bool> &matched);
+    size_t RegexMatchAll(const std::vector<std::string> &inputs, const std::regex &pattern, std::vector<bool> &matched);
+    size_t RegexMatchAll(const std::vector<std::wstring> &inputs, const std::wregex &pattern, std::vector<bool> &matched);
+    void RegexReplaceAll(const std::vector<std::string> &inputs, const std::regex &pattern,
+        const std::string &sub_str, std::vector<std::string> &outputs);
+    void RegexReplaceAll(const std::vector<std::wstring> &inputs, const std::wregex &pattern,
+        const std::wstring &wsub_str, std::vector<std::wstring> &outputs);
+
+    /* ģʽƥ */
+    struct PatternMatch
+    {
+        size_t pattern;     // ģʽڹʱбе±
+        size_t offset;      // ƥıеʼλ
+        size_t length;
+    };
+
+    // Aho-CorasickԶֻڶ̼߳乲һɨ輴ҳģʽȫƥ
+    class MultiPatternMatcher
+    {
+    public:
+        MultiPatternMatcher();
+        explicit MultiPatternMatcher(const std::vector<std::string>& patterns, bool ignore_case = false);
+
+        // ¹Զignore_caseֻASCIIĸСдģʽ
+        void Build(const std::vector<std::string>& patterns, bool ignore_case = false);
+        size_t PatternCount() const { return _lengths_.size(); }
+
+        // Ƿƥ䣬һƥ伴
+        bool Search(const StringView& text) const;
+        // ƥ䣨صλͬһλỵ̄ƥ
+        size_t FindAll(const StringView& text, std::vector<PatternMatch>& matches) const;
+
+    private:
+        int32_t Next(int32_t state, unsigned char c) const
+        {
+            return _delta_[state * _class_count_ + _classes_[c]];
+        }
+
+        uint16_t _classes_[256];           // ֽڵַӳ䣬ģʽеֽڶΪ0
+        size_t _class_count_;
+        std::vector<int32_t> _delta_;      // ״̬תƱ״̬ * ַ
+        std::vector<int32_t> _first_out_;  // ״̬ʧֹ״̬ûʱΪ-1
+        std::vector<int32_t> _dict_;       // ֹ״̬ʧһֹ״̬
+        std::vector<int32_t> _out_begin_;  // ֹ״̬Ӧģʽ_out_еķΧ
+        std::vector<int32_t> _out_;
+        std::vector<size_t> _lengths_;
+    };
+
+    // жǷֻ'|'ɣѸѡ֧дliterals
+    // ģʽַRegexSearch(str, reg_str)ݴԶMultiPatternMatcher
+    bool ParseLiteralPattern(const std::string &reg_str, std::vector<std::string> &literals);
+
+    bool RegexSearch(const std::string &str, const MultiPatternMatcher &matcher);
+    bool RegexSearch(const std::string &str, std::vector<PatternMatch> &matches, const MultiPatternMatcher &matcher);
+
+    /* СдתֻתASCIIĸlocale޹أʹSIMD */
+    std::string toLower(const StringView& str);
+    std::string toUpper(const StringView& str);
+    // д÷ṩĻdstsizeֽڣdstsrcͬ
+    void toLower(const char* src, size_t size, char* dst);
+    void toUpper(const char* src, size_t size, char* dst);
+    std::string& toLowerInplace(std::string& str);
+    std::string& toUpperInplace(std::string& str);
+
+    /* ASCIIСдıȽϣֱıȽʱתСд */
+    int icompare(const StringView& a, const StringView& b);
+    inline bool iequals(const StringView& a, const StringView& b)
+    {
+        return a.size() == b.size() && icompare(a, b) == 0;
+    }
+    size_t ihash(const StringView& str);
+
+    struct IEqual
+    {
+        bool operator()(const StringView& a, const StringView& b) const { return iequals(a, b); }
+    };
+    struct ILess
+    {
+        bool operator()(const StringView& a, const StringView& b) const { return icompare(a, b) < 0; }
+    };
+    struct IHash
+    {
+        size_t operator()(const StringView& str) const { return ihash(str); }
+    };
+    // ִСдĹϣStringView::operator==һStringViewΪ
+    struct StringViewHash
+    {
+        size_t operator()(const StringView& str) const;
+    };
 
     /* ַͻת */
     template <typename T>
@@ -117,8 +477,40 @@ namespace htk
         return ss.str();
     }
 
-    // ȫת
+    // ͵ػstringstreamͨʵһ£ͷĿհףܳǰ׺
+    // ޷ʱ0Χʱ͵/СֵboolParseBoolֵ֧д
+    // ָ֮ͬ("5e")ֵõ50޷'-'0
+    template <> int ConvertFromString<int>(const std::string &s);
+    template <> long ConvertFromString<long>(const std::string &s);
+    template <> long long ConvertFromString<long long>(const std::string &s);
+    template <> unsigned int ConvertFromString<unsigned int>(const std::string &s);
+    template <> unsigned long ConvertFromString<unsigned long>(const std::string &s);
+    template <> unsigned long long ConvertFromString<unsigned long long>(const std::string &s);
+    template <> float ConvertFromString<float>(const std::string &s);
+    template <> double ConvertFromString<double>(const std::string &s);
+    template <> bool ConvertFromString<bool>(const std::string &s);
+
+    // std::fixedһ6λСbool1/0
+    template <> std::string ConvertToString<int>(const int &s);
+    template <> std::string ConvertToString<long>(const long &s);
+    template <> std::string ConvertToString<long long>(const long long &s);
+    template <> std::string ConvertToString<unsigned int>(const unsigned int &s);
+    template <> std::string ConvertToString<unsigned long>(const unsigned long &s);
+    template <> std::string ConvertToString<unsigned long long>(const unsigned long long &s);
+    template <> std::string ConvertToString<float>(const float &s);
+    template <> std::string ConvertToString<double>(const double &s);
+    template <> std::string ConvertToString<bool>(const bool &s);
+
+    // ȫתǣΪGBK/GB18030
     std::string SBC2DBC(const std::string &SBC);
+    // д÷Ļ볤dstsrcͬдֽ
+    size_t SBC2DBC(const char* src, size_t size, char* dst);
+    std::string& SBC2DBCInplace(std::string& str);
+
+    // ȫתǣΪUTF-8룺U+FF01~U+FF5EתΪӦASCIIַȫǿոU+3000תΪո
+    std::string SBC2DBCUTF8(const StringView& sbc);
+    size_t SBC2DBCUTF8(const char* src, size_t size, char* dst);
+    std::string& SBC2DBCUTF8Inplace(std::string& str);
 }
 
 
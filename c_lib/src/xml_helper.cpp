@@ -22,6 +22,7 @@ distribution.
 */
 
 #include "xml_helper.h"
+#include "program_helper.h"
 
 #include <new>		// yes, this one new style header, is in the Android SDK.
 #if defined(ANDROID_NDK) || defined(__BORLANDC__) || defined(__QNXNTO__)
@@ -2302,6 +2303,7 @@ XMLError XMLDocument::LoadFile( const char* filename )
 
 XMLError XMLDocument::LoadFile( FILE* fp )
 {
+    TRACE_SCOPE( "xml.LoadFile" );
     Clear();
 
     TIXML_FSEEK( fp, 0, SEEK_SET );
@@ -2375,6 +2377,7 @@ XMLError XMLDocument::SaveFile( const char* filename, bool compact )
 
 XMLError XMLDocument::SaveFile( FILE* fp, bool compact )
 {
+    TRACE_SCOPE( "xml.SaveFile" );
     // Clear any error from the last save, otherwise it will get reported
     // for *this* call.
     ClearError();
@@ -2481,6 +2484,7 @@ const char* XMLDocument::ErrorName() const
 
 void XMLDocument::Parse()
 {
+    TRACE_SCOPE( "xml.Parse" );
     TIXMLASSERT( NoChildren() ); // Clear() must have been called previously
     TIXMLASSERT( _charBuffer );
     _parseCurLineNum = 1;
@@ -0,0 +1,758 @@
+#include <set>
+#include <random>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+#include <stdint.h>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "zlib.h"
+#include "file_helper.h"
+#include "test_helper.h"
+
+using namespace htk;
+
+// ͳoperator newĵôڼȵ·ڴ
+static std::atomic<size_t> g_allocations(0);
+
+void* operator new(size_t size)
+{
+    ++g_allocations;
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+static std::vector<std::string> RowStrings(const std::vector<CSVField>& row)
+{
+    std::vector<std::string> items;
+    for (size_t i = 0; i < row.size(); ++i)
+    {
+        items.push_back(row[i].str());
+    }
+    return items;
+}
+
+// ϷָšкַͨǿԽ64ֽݿ
+static std::string RandomCSVText(std::mt19937& rng, size_t size, const char* alphabet)
+{
+    std::string text;
+    const size_t count = strlen(alphabet);
+    for (size_t i = 0; i < size; ++i)
+    {
+        text += alphabet[rng() % count];
+    }
+    return text;
+}
+
+// ڴӳȡĽSimpleReadCSVͬ\rСעкͶַָ
+static void TestMappedCSV()
+{
+    const std::string path = "t_file_helper_mapped.csv";
+    std::mt19937 rng(31);
+    const char* delimiters[] = { ",", "::" };
+    for (int round = 0; round < 200; ++round)
+    {
+        const std::string delimiter = delimiters[round % 2];
+        WriteTestFile(path, RandomCSVText(rng, rng() % 300, "ab,:\r\n# "));
+        std::vector<std::vector<std::string> > expected;
+        CHECK(SimpleReadCSV(path, expected, delimiter));
+
+        MappedCSV csv;
+        CHECK(csv.Open(path, delimiter));
+        CHECK_EQ(csv.RowCount(), expected.size());
+        std::vector<StringView> fields;
+        for (size_t row = 0; row < csv.RowCount() && row < expected.size(); ++row)
+        {
+            csv.SplitRow(row, fields);
+            CHECK_EQ(fields.size(), expected[row].size());
+            CHECK_EQ(csv.FieldCount(row), expected[row].size());
+            for (size_t col = 0; col < fields.size() && col < expected[row].size(); ++col)
+            {
+                CHECK(fields[col] == StringView(expected[row][col]));
+                CHECK(csv.GetField(row, col) == StringView(expected[row][col]));
+            }
+        }
+    }
+    remove(path.c_str());
+}
+
+typedef std::vector<std::vector<std::string> > CSVRows;
+
+// ȥŲԭתţCSVField::strͬ
+static std::string UnquoteField(const std::string& field)
+{
+    if (field.size() < 2 || field[0] != '"' || field[field.size() - 1] != '"')
+    {
+        return field;
+    }
+    std::string value;
+    for (size_t i = 1; i + 1 < field.size(); ++i)
+    {
+        value += field[i];
+        if (field[i] == '"' && i + 2 < field.size() && field[i + 1] == '"')
+        {
+            ++i;
+        }
+    }
+    return value;
+}
+
+// ַĲοʵ֣CSVParserSIMDʵ
+static CSVRows ReferenceParse(const std::string& data, bool skip_empty_lines)
+{
+    CSVRows rows;
+    std::vector<std::string> row;
+    size_t field_start = 0;
+    size_t row_start = 0;
+    bool in_quote = false;
+    for (size_t i = 0; i <= data.size(); ++i)
+    {
+        bool at_end = i == data.size();
+        if (!at_end && data[i] == '"')
+        {
+            in_quote = !in_quote;
+            continue;
+        }
+        if (!at_end && (in_quote || (data[i] != ',' && data[i] != '\n')))
+        {
+            continue;
+        }
+        if (at_end && field_start == data.size() && row.empty())
+        {
+            break;
+        }
+        size_t end = i;
+        if ((at_end || data[i] == '\n') && end > field_start && data[end - 1] == '\r')
+        {
+            --end;
+        }
+        row.push_back(UnquoteField(data.substr(field_start, end - field_start)));
+        field_start = i + 1;
+        if (!at_end && data[i] == ',')
+        {
+            continue;
+        }
+        if (!(skip_empty_lines && row.size() == 1 && end == row_start))
+        {
+            rows.push_back(row);
+        }
+        row.clear();
+        row_start = i + 1;
+    }
+    return rows;
+}
+
+static CSVRows ParseAll(const CSVParser& parser, const std::string& data)
+{
+    CSVRows rows;
+    parser.Parse(data.data(), data.size(), [&](const std::vector<CSVField>& row) {
+        rows.push_back(RowStrings(row));
+        return true;
+    });
+    return rows;
+}
+
+// SIMDοʵһ£ڵķָͻСתš\r\nͿ
+static void TestCSVParser()
+{
+    std::mt19937 rng(32);
+    for (int round = 0; round < 2000; ++round)
+    {
+        std::string data = RandomCSVText(rng, rng() % 400, round % 2 ? "a,\"\n\r" : "abc,,\"\n");
+        CSVOptions options;
+        options.skip_empty_lines = round % 3 != 0;
+        CSVRows rows = ParseAll(CSVParser(options), data);
+        CHECK(rows == ReferenceParse(data, options.skip_empty_lines));
+    }
+
+    CHECK(ParseAll(CSVParser(), "a,\"b,\"\"c\"\"\nd\"\r\n\n,\n") ==
+        CSVRows({ { "a", "b,\"c\"\nd" }, { "", "" } }));
+
+    CSVOptions options;
+    options.comment = '#';
+    options.delimiter = ';';
+    CHECK(ParseAll(CSVParser(options), "#x;\"y\n1;2\n#\"\n3;\"#4\"") ==
+        CSVRows({ { "1", "2" }, { "3", "#4" } }));
+
+    // δʱĩβһν
+    std::string partial = "1,2\n3,\"4\n";
+    CSVRows rows;
+    size_t consumed = CSVParser().Parse(partial.data(), partial.size(), [&](const std::vector<CSVField>& row) {
+        rows.push_back(RowStrings(row));
+        return true;
+    }, false);
+    CHECK_EQ(consumed, 4u);
+    CHECK(rows == CSVRows({ { "1", "2" } }));
+}
+
+// ڱ뵥Ԫľ̬ʼ׶νʱеȫֱܻûгʼ
+static const CSVRows g_static_init_rows = ParseAll(CSVParser(), "a,b\n\"c\",d\n");
+
+static void TestParseDuringStaticInit()
+{
+    CHECK(g_static_init_rows == CSVRows({ { "a", "b" }, { "c", "d" } }));
+}
+
+// ߳̽Ľƴ֮뵥߽߳̽ͬںעʱҲһ
+static void TestParallelParseCSV()
+{
+    std::mt19937 rng(33);
+    const char* alphabets[] = { "abcdefgh,,\n\n\"", "abcdefghijklmn,\n\"#" };
+    for (int round = 0; round < 4; ++round)
+    {
+        std::string data = RandomCSVText(rng, (4 << 20) + rng() % 1000, alphabets[round % 2]);
+        CSVOptions options;
+        if (round % 2)
+        {
+            options.comment = '#';
+        }
+        CSVRows expected = ParseAll(CSVParser(options), data);
+        const int thread_num = 4;
+        std::vector<CSVRows> chunks(thread_num);
+        CHECK(ParallelParseCSV(data.data(), data.size(), options,
+            [&](size_t chunk, const std::vector<CSVField>& row) {
+                chunks[chunk].push_back(RowStrings(row));
+                return true;
+            }, thread_num));
+        CSVRows rows;
+        for (size_t i = 0; i < chunks.size(); ++i)
+        {
+            rows.insert(rows.end(), chunks[i].begin(), chunks[i].end());
+        }
+        CHECK(!chunks[1].empty());
+        CHECK(rows == expected);
+
+        if (round == 0)
+        {
+            const std::string path = "t_file_helper_parallel.csv";
+            WriteTestFile(path, data);
+            CSVRows parallel_rows;
+            CHECK(ParallelReadCSV(path, parallel_rows, options, thread_num));
+            CHECK(parallel_rows == expected);
+            remove(path.c_str());
+        }
+    }
+
+    // صfalseʱֹ߳ͣ
+    std::string data = RandomCSVText(rng, 4 << 20, "abc,\n");
+    CHECK(!ParallelParseCSV(data.data(), data.size(), CSVOptions(),
+        [](size_t, const std::vector<CSVField>&) { return false; }, 4));
+}
+
+// жȡԽкڵĻУȡʱٷл
+static void TestReadRow()
+{
+    const std::string path = "t_file_helper_read_row.csv";
+    std::string content = "a,b,c\n\"x,1\",\"say \"\"hi\"\"\",\"line1\nline2\"\n";
+    for (int i = 0; i < 200; ++i)
+    {
+        content += "row" + std::to_string(i) + ",1,2\n";
+    }
+    content += "last,no,newline";
+    WriteTestFile(path, content);
+
+    CSVReader reader(CSVOptions(), 64);
+    CHECK(reader.Open(path));
+    std::vector<CSVField> fields;
+    CHECK(reader.ReadRow(fields));
+    CHECK(RowStrings(fields) == std::vector<std::string>({ "a", "b", "c" }));
+    CHECK(reader.ReadRow(fields));
+    CHECK(RowStrings(fields) == std::vector<std::string>({ "x,1", "say \"hi\"", "line1\nline2" }));
+
+    std::set<const CSVField*> buffers;
+    for (int i = 0; i < 200; ++i)
+    {
+        CHECK(reader.ReadRow(fields));
+        CHECK(RowStrings(fields) == std::vector<std::string>({ "row" + std::to_string(i), "1", "2" }));
+        if (i >= 2)
+        {
+            buffers.insert(fields.data());
+        }
+    }
+    // ڲл彻ֻڴֻ֮
+    CHECK(buffers.size() <= 2);
+    CHECK(reader.ReadRow(fields));
+    CHECK(RowStrings(fields) == std::vector<std::string>({ "last", "no", "newline" }));
+    CHECK(!reader.ReadRow(fields));
+    CHECK(!reader.Failed());
+    remove(path.c_str());
+}
+
+// мأֵнʧֶܵαΪЧ
+static void TestColumnsLoad()
+{
+    const std::string path = "t_file_helper_columns.csv";
+    WriteTestFile(path, "id,score,name\n1,2.5,\"a,b\"\n2,x,c\n");
+    std::vector<CSVColumnSpec> schema = { { 0, CSV_INT64 }, { 1, CSV_DOUBLE }, { 2, CSV_STRING } };
+    CSVColumns columns;
+    CHECK(columns.Load(path, schema, CSVOptions(), true));
+    CHECK_EQ(columns.RowCount(), 2u);
+    CHECK_EQ(columns.Column(0).name(), "id");
+    CHECK_EQ(columns.Column(0).ints()[1], 2);
+    CHECK_EQ(columns.Column(1).doubles()[0], 2.5);
+    CHECK(!columns.Column(1).IsValid(1));
+    CHECK(columns.Column(2).GetString(0) == StringView("a,b"));
+    remove(path.c_str());
+}
+
+// ضϵѹļܵسɹ
+static void TestColumnsLoadTruncated()
+{
+    const std::string path = "t_file_helper_truncated.csv.gz";
+    CSVWriter writer;
+    CHECK(writer.Open(path, 6));
+    for (int i = 0; i < 10000; ++i)
+    {
+        writer.WriteInt(i);
+        writer.WriteDouble(i * 0.5);
+        writer.EndRow();
+    }
+    CHECK(writer.Close());
+    std::string data = ReadTestFile(path);
+    CHECK(data.size() > 100);
+    WriteTestFile(path, data.substr(0, data.size() / 2));
+
+    std::vector<CSVColumnSpec> schema = { { 0, CSV_INT64 }, { 1, CSV_DOUBLE } };
+    CSVColumns columns;
+    CHECK(!columns.Load(path, schema));
+    remove(path.c_str());
+}
+
+// "80,""x "ȿͷͨıǡzlibͷУ飬ܱѹ
+static void TestPlainDetection()
+{
+    const std::string path = "t_file_helper_plain.csv";
+    const std::vector<std::vector<std::string> > expected = { { "80", "100" }, { "81", "200" } };
+    WriteTestFile(path, "80,100\n81,200\n");
+
+    std::vector<std::vector<std::string> > rows;
+    CHECK(ReadCSV(path, rows));
+    CHECK(rows == expected);
+    rows.clear();
+    CHECK(ParallelReadCSV(path, rows));
+    CHECK(rows == expected);
+
+    CSVReader reader;
+    CHECK(reader.Open(path));
+    std::vector<CSVField> fields;
+    size_t count = 0;
+    while (reader.ReadRow(fields))
+    {
+        CHECK(RowStrings(fields) == expected[count]);
+        ++count;
+    }
+    CHECK_EQ(count, 2u);
+    CHECK(!reader.Failed());
+
+    WriteTestFile(path, "x y\n");
+    CHECK(ReadCSV(path, rows));
+    CHECK(rows == std::vector<std::vector<std::string> >({ { "x y" } }));
+    remove(path.c_str());
+}
+
+// gzipԶʶzlibҪʽָ
+static void TestCompressedDetection()
+{
+    const std::string gz_path = "t_file_helper_detect.csv.gz";
+    CSVWriter writer;
+    CHECK(writer.Open(gz_path, 6));
+    writer.WriteField("80");
+    writer.WriteInt(100);
+    writer.EndRow();
+    CHECK(writer.Close());
+    std::vector<std::vector<std::string> > rows;
+    CHECK(ReadCSV(gz_path, rows));
+    CHECK(rows == std::vector<std::vector<std::string> >({ { "80", "100" } }));
+
+    const std::string zlib_path = "t_file_helper_detect.csv.z";
+    const std::string plain = "a,b\n1,2\n";
+    std::vector<Bytef> packed(compressBound(plain.size()));
+    uLongf packed_size = packed.size();
+    CHECK(compress2(&packed[0], &packed_size, reinterpret_cast<const Bytef*>(plain.data()), plain.size(), 6) == Z_OK);
+    WriteTestFile(zlib_path, std::string(reinterpret_cast<const char*>(&packed[0]), packed_size));
+
+    CSVOptions options;
+    options.compression = CSV_COMPRESSION_ZLIB;
+    CHECK(ReadCSV(zlib_path, rows, options));
+    CHECK(rows == std::vector<std::vector<std::string> >({ { "a", "b" }, { "1", "2" } }));
+    options.compression = CSV_COMPRESSION_NONE;
+    CHECK(ReadCSV(gz_path, rows, options));
+    CHECK(rows.empty() || rows[0][0] != "80");
+    remove(gz_path.c_str());
+    remove(zlib_path.c_str());
+}
+
+// ԤȽĿ͵ķΧʱܽض
+static void TestConfigIntRange()
+{
+    const std::string path = "t_file_helper_config.conf";
+    WriteTestFile(path, "small = 42\nbig = 3000000000\nnegative = -5\n");
+    SimpleConfig config(path);
+    CHECK_EQ(config.get<int>("small"), 42);
+    CHECK_EQ(config.get<int>("big"), std::numeric_limits<int>::max());
+    CHECK_EQ(config.get<long long>("big"), 3000000000LL);
+    CHECK_EQ(config.get<unsigned int>("big"), 3000000000u);
+    CHECK_EQ(config.get<short>("negative"), -5);
+    CHECK_EQ(config.get<unsigned char>("small"), 42);
+    CHECK_EQ(config.get<unsigned int>("negative"), 0u);
+    remove(path.c_str());
+}
+
+struct TestTileConfig
+{
+    int level;
+    std::string format;
+    double scale;
+    bool cache;
+};
+
+// [section]µļsectionǰ׺ԭеĴ'.'ļݣSectionȡǶ׵ãBindConfigһΰ󶨵ṹ
+static void TestConfigSections()
+{
+    const std::string path = "t_file_helper_sections.conf";
+    WriteTestFile(path,
+        "name = global\n"
+        "tile.png.level = 3\n"
+        "[ tile ]\n"
+        "level = 12\n"
+        "format = jpg\n"
+        "# scale = 9\n"
+        "[tile.png]\n"
+        "scale = 0.5\r\n"
+        "cache = yes\n"
+        "[]\n"
+        "tail = 1\n");
+    SimpleConfig config(path);
+    CHECK_EQ(config.get<std::string>("name"), "global");
+    CHECK_EQ(config.get<int>("tile.level"), 12);
+    CHECK_EQ(config.get<std::string>("tile.png.scale"), "0.5");
+    CHECK_EQ(config.get<int>("tile.png.level"), 3);
+    CHECK_EQ(config.get<int>("tail"), 1);
+    CHECK(config.Find("level") == NULL);
+    CHECK(config.Find("tile.scale") == NULL);
+
+    SimpleConfig tile = config.Section("tile");
+    CHECK_EQ(tile.GetData().size(), 5u);
+    CHECK_EQ(tile.get<std::string>("format"), "jpg");
+    CHECK_EQ(tile.get<double>("png.scale"), 0.5);
+    SimpleConfig png = tile.Section("png");
+    CHECK_EQ(png.GetData().size(), 3u);
+    CHECK(config.Section("tile.png").GetData() == png.GetData());
+    CHECK(config.Section("til").GetData().empty());
+
+    TestTileConfig target = { 1, "png", 1.0, false };
+    CHECK(BindConfig(png, target,
+        MakeConfigKey("level", &TestTileConfig::level, true),
+        MakeConfigKey("scale", &TestTileConfig::scale),
+        MakeConfigKey("cache", &TestTileConfig::cache),
+        MakeConfigKey("format", &TestTileConfig::format)));
+    CHECK_EQ(target.level, 3);
+    CHECK_EQ(target.scale, 0.5);
+    CHECK(target.cache);
+    CHECK_EQ(target.format, "png");
+
+    // ļȱʧʱfalseļճ
+    TestTileConfig partial = { 1, "png", 1.0, false };
+    CHECK(!BindConfig(tile, partial,
+        MakeConfigKey("scale", &TestTileConfig::scale, true),
+        MakeConfigKey("level", &TestTileConfig::level)));
+    CHECK_EQ(partial.level, 12);
+    CHECK_EQ(partial.scale, 1.0);
+    CHECK(BindConfig(tile, partial));
+    remove(path.c_str());
+}
+
+// ҺͶȡԤȽֵڴ棻ƳԭٺȻ
+static void TestConfigLookupNoAlloc()
+{
+    const std::string path = "t_file_helper_lookup.conf";
+    WriteTestFile(path, "[service.tile.renderer]\nlevel = 12\nratio = 0.25\nenabled = on\n"
+        "format = png with a long description\nlist = a, b, c\n");
+    SimpleConfig* original = new SimpleConfig(path);
+    SimpleConfig config(*original);
+    delete original;
+
+    size_t before = g_allocations.load();
+    int64_t sum = 0;
+    size_t chars = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+        sum += config.get<int>("service.tile.renderer.level");
+        sum += config.get<double>("service.tile.renderer.ratio") * 4;
+        sum += config.get<bool>("service.tile.renderer.enabled");
+        sum += config.get<int>("service.tile.renderer.missing", 1);
+        chars += config.GetValue("service.tile.renderer.format").str().size();
+        chars += config.GetValue("service.tile.renderer.list").AsList().size();
+    }
+    CHECK_EQ(g_allocations.load(), before);
+    CHECK_EQ(sum, 15000);
+    CHECK_EQ(chars, 30000u);
+
+    struct Renderer
+    {
+        int level;
+        bool enabled;
+    } renderer = { 0, false };
+    SimpleConfig section = config.Section("service.tile.renderer");
+    before = g_allocations.load();
+    CHECK(BindConfig(section, renderer,
+        MakeConfigKey("level", &Renderer::level, true),
+        MakeConfigKey("enabled", &Renderer::enabled, true)));
+    CHECK_EQ(g_allocations.load(), before);
+    CHECK_EQ(renderer.level, 12);
+    CHECK(renderer.enabled);
+
+    SimpleConfig assigned;
+    assigned = section;
+    section = SimpleConfig();
+    CHECK_EQ(assigned.get<std::string>("format"), "png with a long description");
+    CHECK(assigned.GetValue("list").AsList() == std::vector<std::string>({ "a", "b", "c" }));
+    remove(path.c_str());
+}
+
+// ȴð汾仯ʱfalse
+static bool WaitVersion(const ReloadableConfig& config, size_t version)
+{
+    for (int i = 0; i < 500 && config.Version() == version; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return config.Version() != version;
+}
+
+static void OnTestSignal(int)
+{
+}
+
+// ȴɿȫգʱfalse
+static bool WaitReclaimed(const ReloadableConfig& config)
+{
+    for (int i = 0; i < 500 && config.PendingSnapshots() != 0; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return config.PendingSnapshots() == 0;
+}
+
+// ReloadȴпյĶȡߣɿڳͷ֮գ̱߳źж֮
+static void TestReloadableConfig()
+{
+    const std::string path = "t_file_helper_reload.conf";
+    WriteTestFile(path, "value = 1\n");
+    ReloadableConfig config;
+    CHECK(config.Start(path));
+
+    ReloadableConfig::SnapshotPtr first = config.Snapshot();
+    for (int i = 2; i <= 100; ++i)
+    {
+        WriteTestFile(path, "value = " + std::to_string(i) + "\n");
+        CHECK(config.Reload());
+    }
+    CHECK_EQ(config.Snapshot()->get<int>("value"), 100);
+    // ԱеĿձЧڼ滻ĿնҪͷ
+    CHECK_EQ(first->get<int>("value"), 1);
+    CHECK(config.PendingSnapshots() >= 99);
+    ReloadableConfig::SnapshotPtr copy = first;
+    first.reset();
+    CHECK(!first);
+    CHECK_EQ(copy->get<int>("value"), 1);
+    CHECK(config.PendingSnapshots() >= 99);
+    copy.reset();
+    // ߳ûг֮ɻ
+    CHECK(WaitReclaimed(config));
+
+    // ߳ⶼźţ֤źжϵǼ߳еpoll
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = OnTestSignal;
+    sigaction(SIGUSR1, &action, NULL);
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    kill(getpid(), SIGUSR1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    size_t version = config.Version();
+    WriteTestFile(path, "value = 200\n");
+    CHECK(WaitVersion(config, version));
+    CHECK_EQ(config.Snapshot()->get<int>("value"), 200);
+    config.Stop();
+    pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+    remove(path.c_str());
+}
+
+// ¼ڼȡ߲ȴһֱľɿգȡʱɿղǰͷ
+static void TestSnapshotDuringReload()
+{
+    const std::string path = "t_file_helper_fifo.conf";
+    WriteTestFile(path, "value = 1\ncheck = 1\n");
+    ReloadableConfig config;
+    CHECK(config.Start(path));
+    config.Stop();
+
+    // ļܵ¼ػͣڶȡļϣֱдݲر
+    remove(path.c_str());
+    CHECK(mkfifo(path.c_str(), 0600) == 0);
+    ReloadableConfig::SnapshotPtr held = config.Snapshot();
+    std::atomic<bool> reloaded(false);
+    std::thread reloader([&config, &reloaded]() {
+        reloaded.store(config.Reload());
+    });
+    // 򿪳ɹʱ¼Ѿʼȡļ
+    int fifo = open(path.c_str(), O_WRONLY);
+    CHECK(fifo >= 0);
+    std::atomic<bool> read_done(false);
+    std::thread reader([&config, &read_done]() {
+        ReloadableConfig::SnapshotPtr snapshot = config.Snapshot();
+        read_done.store(snapshot && snapshot->get<int>("value") == 1);
+    });
+    for (int i = 0; i < 200 && !read_done.load(); ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    // пյĶȡߺڽе¼ضµĶȡߵȴ
+    CHECK(read_done.load());
+    const std::string content = "value = 2\ncheck = 2\n";
+    CHECK(write(fifo, content.data(), content.size()) == static_cast<ssize_t>(content.size()));
+    close(fifo);
+    reader.join();
+    reloader.join();
+    remove(path.c_str());
+    CHECK(reloaded.load());
+    CHECK_EQ(config.Snapshot()->get<int>("value"), 2);
+    CHECK_EQ(held->get<int>("value"), 1);
+    CHECK_EQ(config.PendingSnapshots(), 1u);
+    held.reset();
+
+    // ȡ߿valuecheckͬһգҲᵹ
+    WriteTestFile(path, "value = 1\ncheck = 1\n");
+    CHECK(config.Reload());
+    std::atomic<bool> stop(false);
+    std::atomic<int> errors(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t)
+    {
+        readers.push_back(std::thread([&config, &stop, &errors]() {
+            int last = 0;
+            while (!stop.load())
+            {
+                ReloadableConfig::SnapshotPtr snapshot = config.Snapshot();
+                int value = snapshot->get<int>("value");
+                if (value < last || snapshot->get<int>("check") != value)
+                {
+                    ++errors;
+                }
+                last = value;
+            }
+        }));
+    }
+    for (int i = 2; i <= 300; ++i)
+    {
+        WriteTestFile(path, "value = " + std::to_string(i) + "\ncheck = " + std::to_string(i) + "\n");
+        CHECK(config.Reload());
+    }
+    stop.store(true);
+    for (size_t t = 0; t < readers.size(); ++t)
+    {
+        readers[t].join();
+    }
+    CHECK_EQ(errors.load(), 0);
+    CHECK(config.Reload());
+    CHECK_EQ(config.PendingSnapshots(), 0u);
+    CHECK_EQ(config.Snapshot()->get<int>("value"), 300);
+    remove(path.c_str());
+}
+
+// дݾCSVReader֮дһ
+static void CheckWriterRoundTrip(int compress_level)
+{
+    const std::string path = "t_file_helper_writer.csv";
+    const std::vector<std::vector<std::string> > rows = {
+        { "" },
+        { "5" },
+        { "", "" },
+        { "" },
+        { "plain", "with,comma", "with \"quote\"", "multi\nline", "cr\r" },
+        { "-9223372036854775808", "18446744073709551615", "0.1", "-2.5e-300", "true", "false" },
+        { "" },
+    };
+    CSVWriter writer;
+    CHECK(writer.Open(path, compress_level));
+    writer.WriteField("");
+    writer.EndRow();
+    writer.WriteInt(5);
+    writer.EndRow();
+    writer.WriteRow(rows[2]);
+    writer.WriteRow(rows[3]);
+    writer.WriteRow(rows[4]);
+    writer.WriteInt(INT64_MIN);
+    writer.WriteUInt(UINT64_MAX);
+    writer.WriteDouble(0.1);
+    writer.WriteDouble(-2.5e-300);
+    writer.WriteBool(true);
+    writer.WriteBool(false);
+    writer.EndRow();
+    writer.WriteField("");
+    writer.EndRow();
+    CHECK(writer.Close());
+    if (compress_level == 0)
+    {
+        CHECK(ReadTestFile(path).compare(0, 7, "\"\"\n5\n,\n") == 0);
+    }
+
+    CSVReader reader;
+    CHECK(reader.Open(path));
+    std::vector<CSVField> fields;
+    size_t count = 0;
+    while (reader.ReadRow(fields))
+    {
+        CHECK(count < rows.size() && RowStrings(fields) == rows[count]);
+        ++count;
+    }
+    CHECK_EQ(count, rows.size());
+    CHECK(!reader.Failed());
+    remove(path.c_str());
+}
+
+static void TestWriterRoundTrip()
+{
+    CheckWriterRoundTrip(0);
+    CheckWriterRoundTrip(6);
+}
+
+int main()
+{
+    TestMappedCSV();
+    TestCSVParser();
+    TestParseDuringStaticInit();
+    TestParallelParseCSV();
+    TestReadRow();
+    TestColumnsLoad();
+    TestColumnsLoadTruncated();
+    TestPlainDetection();
+    TestCompressedDetection();
+    TestConfigIntRange();
+    TestConfigSections();
+    TestConfigLookupNoAlloc();
+    TestReloadableConfig();
+    TestSnapshotDuringReload();
+    TestWriterRoundTrip();
+    return TestResult("t_file_helper");
+}
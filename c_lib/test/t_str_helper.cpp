@@ -0,0 +1,824 @@
+#include <cmath>
+#include <clocale>
+#include <cstring>
+#include <random>
+#include <set>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <limits>
+#include <sstream>
+#include "str_helper.h"
+#include "test_helper.h"
+
+using namespace htk;
+
+static std::string RandomText(std::mt19937& rng, size_t size, const char* alphabet)
+{
+    std::string text;
+    const size_t count = strlen(alphabet);
+    for (size_t i = 0; i < size; ++i)
+    {
+        text += alphabet[rng() % count];
+    }
+    return text;
+}
+
+static std::vector<std::string> ViewStrings(const std::vector<StringView>& views)
+{
+    std::vector<std::string> items;
+    for (size_t i = 0; i < views.size(); ++i)
+    {
+        items.push_back(views[i].str());
+    }
+    return items;
+}
+
+// ڴķָsplitsplit_with_quotĽͬ
+static void TestSplitView()
+{
+    std::mt19937 rng(41);
+    const char* delimiters[] = { ",", "::", "ab" };
+    std::vector<StringView> tokens;
+    for (int round = 0; round < 3000; ++round)
+    {
+        std::string str = RandomText(rng, rng() % 40, "ab,: \"");
+        std::string delimiter = delimiters[round % 3];
+        std::string trim_str = round % 2 ? " " : "";
+        split_view(str, delimiter, tokens, trim_str);
+        CHECK(ViewStrings(tokens) == split(str, delimiter, trim_str));
+
+        std::vector<std::string> items;
+        for_each_token(str, delimiter, [&](const StringView& token) {
+            items.push_back(token.str());
+            return true;
+        });
+        CHECK(items == split(str, delimiter));
+
+        split_with_quot_view(str, ',', tokens, '"', trim_str);
+        CHECK(ViewStrings(tokens) == split_with_quot(str, ',', '"', trim_str));
+    }
+}
+
+// ͼáԭؼtrimĽͬ
+static void TestTrim()
+{
+    std::mt19937 rng(42);
+    const CharSet chars(" \t\r");
+    for (int round = 0; round < 3000; ++round)
+    {
+        std::string str = RandomText(rng, rng() % 20, "a \t\rb");
+        CHECK(trim_left_view(str, chars).str() == trim_left(str, " \t\r"));
+        CHECK(trim_right_view(str, chars).str() == trim_right(str, " \t\r"));
+        CHECK(trim_view(str, chars).str() == trim(str, " \t\r"));
+        std::string copy = str;
+        CHECK(trim_inplace(copy, chars) == trim(str, " \t\r"));
+    }
+    CHECK(CharSet().empty());
+    CHECK(CharSet("\xff").contains('\xff'));
+}
+
+static char ReferenceLower(char c)
+{
+    return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+// SIMDСдתֽתһ£ֻתASCIIĸֳȵβȷ
+static void TestCaseConversion()
+{
+    std::mt19937 rng(43);
+    for (int round = 0; round < 2000; ++round)
+    {
+        std::string str;
+        size_t size = rng() % 70;
+        for (size_t i = 0; i < size; ++i)
+        {
+            str += static_cast<char>(rng() % 256);
+        }
+        std::string lower = str;
+        std::string upper = str;
+        for (size_t i = 0; i < str.size(); ++i)
+        {
+            lower[i] = ReferenceLower(str[i]);
+            upper[i] = str[i] >= 'a' && str[i] <= 'z' ? str[i] - 'a' + 'A' : str[i];
+        }
+        CHECK(toLower(str) == lower);
+        CHECK(toUpper(str) == upper);
+        std::string copy = str;
+        CHECK(toLowerInplace(copy) == lower);
+        CHECK(toUpperInplace(copy) == upper);
+
+        std::string a = lower.substr(0, 3) + RandomText(rng, rng() % 4, "aAbB[");
+        std::string b = upper.substr(0, 3) + RandomText(rng, rng() % 4, "aAbB[");
+        int expected = toLower(a).compare(toLower(b));
+        int result = icompare(a, b);
+        CHECK((expected < 0) == (result < 0) && (expected > 0) == (result > 0));
+        CHECK(iequals(a, b) == (expected == 0));
+        CHECK(ihash(lower) == ihash(upper));
+    }
+    CHECK(icompare("abc", "ABD") < 0);
+    CHECK(icompare("abc", "AB") > 0);
+    CHECK(iequals("Content-Type", "content-type"));
+    CHECK(!iequals("\xc0", "\xe0"));
+    CHECK(ILess()("apple", "BANANA"));
+    CHECK(IEqual()("PNG", "png") && IHash()("PNG") == IHash()("png"));
+}
+
+// 򻺴棺ͬģʽԤӿַӿڽһ£̹߳ȫ
+static void TestRegexCache()
+{
+    typedef std::vector<std::string> Strings;
+    const std::string range = "(\\d+)-(\\d+)";
+    RegexPtr pattern = CompileRegex(range);
+    CHECK(pattern == CompileRegex(range));
+    CHECK(pattern != CompileRegex(range, std::regex_constants::icase));
+    bool thrown = false;
+    try
+    {
+        CompileRegex("(unclosed");
+    }
+    catch (const std::regex_error&)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+
+    Strings groups;
+    CHECK(RegexSearch(std::string("tile 12-34.png"), groups, range));
+    CHECK(groups == Strings({ "12-34", "12", "34" }));
+    groups.clear();
+    CHECK(RegexSearch(std::string("tile 12-34.png"), groups, *pattern));
+    CHECK(groups == Strings({ "12-34", "12", "34" }));
+    CHECK(!RegexMatch(std::string("tile 12-34"), *pattern));
+    CHECK(RegexMatch(std::string("12-34"), range));
+    CHECK(RegexReplace(std::string("1-2 and 3-4"), *pattern, "$2-$1") == "2-1 and 4-3");
+    CHECK(RegexReplace(std::string("1-2"), range, std::string("$2-$1")) == "2-1");
+    CHECK(RegexSearch(std::wstring(L"ab12"), std::wstring(L"\\d+")));
+
+    Strings inputs = { "1-2", "x", "3-4 y" };
+    std::vector<bool> matched;
+    CHECK_EQ(RegexSearchAll(inputs, *pattern, matched), 2u);
+    CHECK(matched == std::vector<bool>({ true, false, true }));
+    CHECK_EQ(RegexMatchAll(inputs, *pattern, matched), 1u);
+    CHECK(matched == std::vector<bool>({ true, false, false }));
+    Strings outputs;
+    RegexReplaceAll(inputs, *pattern, "<$&>", outputs);
+    CHECK(outputs == Strings({ "<1-2>", "x", "<3-4> y" }));
+
+    // ջ֮ѾȡõȻ
+    ClearRegexCache();
+    CHECK(pattern != CompileRegex(range));
+    CHECK(RegexMatch(std::string("5-6"), *pattern));
+
+    std::atomic<int> errors(0);
+    std::vector<std::thread*> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.push_back(new std::thread([&errors, t]() {
+            for (int i = 0; i < 200; ++i)
+            {
+                Strings result;
+                std::string id = std::to_string(t * 1000 + i);
+                if (!RegexSearch("id-" + id, result, std::string("id-(\\d+)")) || result.size() != 2 || result[1] != id)
+                {
+                    ++errors;
+                }
+            }
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i]->join();
+        delete threads[i];
+    }
+    CHECK_EQ(errors.load(), 0);
+}
+
+static bool MatchOrder(const PatternMatch& a, const PatternMatch& b)
+{
+    size_t a_end = a.offset + a.length;
+    size_t b_end = b.offset + b.length;
+    return a_end != b_end ? a_end < b_end : a.length > b.length;
+}
+
+// Aho-CorasickҳƥλñȽϵĽȫһ£صƥͺԴСд
+static void TestMultiPatternMatcher()
+{
+    std::mt19937 rng(45);
+    for (int round = 0; round < 500; ++round)
+    {
+        bool ignore_case = round % 2 == 1;
+        std::set<std::string> unique;
+        size_t count = 1 + rng() % 6;
+        while (unique.size() < count)
+        {
+            std::string pattern = RandomText(rng, 1 + rng() % 4, "abAB");
+            unique.insert(ignore_case ? toLower(pattern) : pattern);
+        }
+        std::vector<std::string> patterns(unique.begin(), unique.end());
+        std::string text = RandomText(rng, rng() % 100, "abAB\xe4");
+
+        std::vector<PatternMatch> expected;
+        for (size_t p = 0; p < patterns.size(); ++p)
+        {
+            const std::string& pattern = patterns[p];
+            for (size_t i = 0; i + pattern.size() <= text.size(); ++i)
+            {
+                StringView window(text.data() + i, pattern.size());
+                if (ignore_case ? iequals(window, pattern) : window == StringView(pattern))
+                {
+                    PatternMatch match = { p, i, pattern.size() };
+                    expected.push_back(match);
+                }
+            }
+        }
+        std::stable_sort(expected.begin(), expected.end(), MatchOrder);
+
+        MultiPatternMatcher matcher(patterns, ignore_case);
+        std::vector<PatternMatch> matches;
+        CHECK_EQ(matcher.FindAll(text, matches), expected.size());
+        bool same = matches.size() == expected.size();
+        for (size_t i = 0; same && i < matches.size(); ++i)
+        {
+            same = matches[i].pattern == expected[i].pattern && matches[i].offset == expected[i].offset &&
+                matches[i].length == expected[i].length;
+        }
+        CHECK(same);
+        CHECK(matcher.Search(text) == !expected.empty());
+    }
+
+    std::vector<std::string> literals;
+    CHECK(ParseLiteralPattern("error|warning", literals));
+    CHECK(literals == std::vector<std::string>({ "error", "warning" }));
+    CHECK(!ParseLiteralPattern("err.r", literals));
+    CHECK(!ParseLiteralPattern("(a|b)c", literals));
+    // ģʽԶstd::regexͬ
+    CHECK(RegexSearch(std::string("disk warning: 90%"), std::string("error|warning")));
+    CHECK(!RegexSearch(std::string("all good"), std::string("error|warning")));
+}
+
+static void AppendReferenceUTF8(uint32_t cp, std::string& out)
+{
+    if (cp < 0x80)
+    {
+        out += static_cast<char>(cp);
+    }
+    else if (cp < 0x800)
+    {
+        out += static_cast<char>(0xc0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    }
+    else if (cp < 0x10000)
+    {
+        out += static_cast<char>(0xe0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    }
+    else
+    {
+        out += static_cast<char>(0xf0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    }
+}
+
+static std::string UTF8Replace(const std::string& src, TranscodePolicy policy)
+{
+    std::u32string wide;
+    AppendUTF8ToUTF32(src, wide, policy);
+    std::string out;
+    AppendUTF32ToUTF8(wide, out);
+    return out;
+}
+
+// ϷıUTF-8UTF-16UTF-32֮䣬ǷаǷ滻
+static void TestUnicodeTranscode()
+{
+    std::mt19937 rng(46);
+    for (int round = 0; round < 1000; ++round)
+    {
+        std::u32string expected;
+        std::string utf8;
+        size_t size = rng() % 60;
+        for (size_t i = 0; i < size; ++i)
+        {
+            uint32_t ranges[] = { 0x80, 0x800, 0x10000, 0x110000 };
+            uint32_t cp = rng() % ranges[rng() % 4];
+            if (cp >= 0xd800 && cp < 0xe000)
+            {
+                cp = 'x';
+            }
+            expected += static_cast<char32_t>(cp);
+            AppendReferenceUTF8(cp, utf8);
+        }
+        CHECK(IsValidUTF8(utf8.data(), utf8.size()));
+
+        std::u32string utf32;
+        CHECK(AppendUTF8ToUTF32(utf8, utf32, TRANSCODE_FAIL));
+        CHECK(utf32 == expected);
+        std::u16string utf16;
+        CHECK(AppendUTF8ToUTF16(utf8, utf16, TRANSCODE_FAIL));
+        std::string back;
+        CHECK(AppendUTF16ToUTF8(utf16, back, TRANSCODE_FAIL));
+        CHECK(back == utf8);
+        back.clear();
+        CHECK(AppendUTF32ToUTF8(utf32, back, TRANSCODE_FAIL));
+        CHECK(back == utf8);
+        std::wstring wide;
+        CHECK(AppendUTF8ToWide(utf8, wide));
+        back.clear();
+        CHECK(AppendWideToUTF8(wide, back));
+        CHECK(back == utf8);
+        CHECK(unicode_to_utf8(utf8_to_unicode(utf8)) == utf8);
+    }
+
+    const std::string fffd = "\xef\xbf\xbd";
+    // ʹÿֽ滻һΣضϵ滻һ
+    CHECK(UTF8Replace("a\xc0\xaf" "b", TRANSCODE_REPLACE) == "a" + fffd + fffd + "b");
+    CHECK(UTF8Replace("\xe0\x80\xaf", TRANSCODE_REPLACE) == fffd + fffd + fffd);
+    CHECK(UTF8Replace("\xed\xa0\x80", TRANSCODE_REPLACE) == fffd + fffd + fffd);
+    CHECK(UTF8Replace("\xf0\x9f\x98!", TRANSCODE_REPLACE) == fffd + "!");
+    CHECK(UTF8Replace("\xf4\x90\x80\x80", TRANSCODE_REPLACE) == fffd + fffd + fffd + fffd);
+    CHECK(UTF8Replace("a\xff" "b\x80", TRANSCODE_SKIP) == "ab");
+
+    size_t error_pos = 0;
+    CHECK(!IsValidUTF8("ab\xe4\xb8", 4, &error_pos) && error_pos == 2);
+    char16_t buffer16[8];
+    CHECK(UTF8ToUTF16("ok\xc3", 3, buffer16, TRANSCODE_FAIL, &error_pos) == TRANSCODE_ERROR && error_pos == 2);
+    std::u16string utf16;
+    utf16 += u'a';
+    CHECK(!AppendUTF8ToUTF16("\xff", utf16, TRANSCODE_FAIL) && utf16 == u"a");
+
+    // Ĵ滻ΪU+FFFD
+    std::string out;
+    CHECK(AppendUTF16ToUTF8(std::u16string(1, static_cast<char16_t>(0xd800)) + u"x", out) && out == fffd + "x");
+    out.clear();
+    CHECK(AppendUTF32ToUTF8(std::u32string(1, static_cast<char32_t>(0x110000)), out) && out == fffd);
+}
+
+static std::string ToGB18030(const std::string& utf8, TranscodePolicy policy = TRANSCODE_REPLACE)
+{
+    std::string out;
+    AppendUTF8ToGB18030(utf8, out, policy);
+    return out;
+}
+
+static std::string FromGB18030(const std::string& gb, TranscodePolicy policy = TRANSCODE_REPLACE)
+{
+    std::string out;
+    AppendGB18030ToUTF8(gb, out, policy);
+    return out;
+}
+
+// ˫ֽڡֽںͲƽı׼һ£BMPͲֲƽ
+static void TestGB18030()
+{
+    CHECK(ToGB18030("\xe4\xb8\xad") == "\xd6\xd0");                 // 
+    CHECK(ToGB18030("\xe2\x82\xac") == "\xa2\xe3");                 // ŷԪ
+    CHECK(ToGB18030("\xc2\xb7") == "\xa1\xa4");                     // 
+    CHECK(ToGB18030("\xc2\x80") == "\x81\x30\x81\x30");             // U+0080
+    CHECK(ToGB18030("\xef\xbf\xbf") == "\x84\x31\xa4\x39");         // U+FFFF
+    CHECK(ToGB18030("\xf0\x90\x80\x80") == "\x90\x30\x81\x30");     // U+10000
+    CHECK(FromGB18030("abc\xd6\xd0") == "abc\xe4\xb8\xad");
+    CHECK(GBK2UTF8("\xd6\xd0") == "\xe4\xb8\xad");
+    CHECK(UTF82GBK("\xe4\xb8\xad") == "\xd6\xd0");
+
+    std::string utf8;
+    for (uint32_t cp = 0; cp < 0x10000; ++cp)
+    {
+        if (cp < 0xd800 || cp >= 0xe000)
+        {
+            AppendReferenceUTF8(cp, utf8);
+        }
+    }
+    for (uint32_t cp = 0x10000; cp < 0x110000; cp += 0x1001)
+    {
+        AppendReferenceUTF8(cp, utf8);
+    }
+    std::string gb = ToGB18030(utf8, TRANSCODE_FAIL);
+    CHECK(!gb.empty());
+    CHECK(FromGB18030(gb, TRANSCODE_FAIL) == utf8);
+
+    // Ƿͽضϵ
+    const std::string fffd = "\xef\xbf\xbd";
+    CHECK(FromGB18030("\x81") == fffd);
+    CHECK(FromGB18030("a\xff") == "a" + fffd);
+    CHECK(FromGB18030("\x81\x30\x81") == fffd);
+    CHECK(FromGB18030("a\xff", TRANSCODE_SKIP) == "a");
+    char buffer[16];
+    size_t error_pos = 0;
+    CHECK(GB18030ToUTF8("ab\x81", 3, buffer, TRANSCODE_FAIL, &error_pos) == TRANSCODE_ERROR && error_pos == 2);
+    CHECK(UTF8ToGB18030("a\xc3", 2, buffer, TRANSCODE_FAIL, &error_pos) == TRANSCODE_ERROR && error_pos == 1);
+}
+
+// ⣬Լ߳ת롢ļת뵥߳תһ
+static void TestDetectAndTranscode()
+{
+    std::string utf8_line = "\xe4\xb8\xad\xe6\x96\x87 text, \xe7\xbc\x96\xe7\xa0\x81\n";
+    std::string utf8;
+    // 4MBParallelTranscodeг4
+    for (int i = 0; i < 150000; ++i)
+    {
+        utf8 += std::to_string(i) + " " + utf8_line;
+    }
+    std::string gb = ToGB18030(utf8);
+    CHECK_EQ(DetectEncoding("plain ascii\n", 12), ENCODING_ASCII);
+    CHECK_EQ(DetectEncoding(utf8.data(), utf8.size()), ENCODING_UTF8);
+    CHECK_EQ(DetectEncoding(gb.data(), gb.size()), ENCODING_GB18030);
+    CHECK_EQ(DetectEncoding(gb.data(), gb.size(), 1024), ENCODING_GB18030);
+    CHECK_EQ(DetectEncoding("\xef\xbb\xbf\xd6\xd0", 5), ENCODING_UTF8);
+
+    std::string out;
+    CHECK(Transcode(gb.data(), gb.size(), ENCODING_UNKNOWN, ENCODING_UTF8, out));
+    CHECK(out == utf8);
+
+    // Ƿֽڣ߳ڻдпĽ뵥߳ȫͬ
+    std::mt19937 rng(48);
+    std::string broken = gb;
+    for (int i = 0; i < 50; ++i)
+    {
+        broken[rng() % broken.size()] = static_cast<char>(0x80 | rng() % 128);
+    }
+    const TranscodePolicy policies[] = { TRANSCODE_REPLACE, TRANSCODE_SKIP, TRANSCODE_FAIL };
+    for (size_t i = 0; i < 3; ++i)
+    {
+        std::string single;
+        std::string parallel;
+        size_t single_pos = 0;
+        size_t parallel_pos = 0;
+        bool single_ok = Transcode(broken.data(), broken.size(), ENCODING_GB18030, ENCODING_UTF8,
+            single, policies[i], &single_pos);
+        bool parallel_ok = ParallelTranscode(broken.data(), broken.size(), ENCODING_GB18030, ENCODING_UTF8,
+            parallel, policies[i], &parallel_pos, 4);
+        CHECK(single_ok == parallel_ok && single == parallel);
+        CHECK(single_ok || single_pos == parallel_pos);
+    }
+
+    const std::string src_path = "t_str_helper_gb.txt";
+    const std::string dst_path = "t_str_helper_utf8.txt";
+    WriteTestFile(src_path, gb);
+    CHECK(TranscodeFile(src_path, dst_path, ENCODING_UTF8, ENCODING_UNKNOWN, TRANSCODE_FAIL, 2));
+    CHECK(ReadTestFile(dst_path) == utf8);
+    CHECK(TranscodeFile(dst_path, src_path, ENCODING_GB18030));
+    CHECK(ReadTestFile(src_path) == gb);
+    remove(src_path.c_str());
+    remove(dst_path.c_str());
+}
+
+// ȫתǣGBUTF-8ʵֶͬһıĽһ£ԭغַӿһ
+static void TestSBC2DBC()
+{
+    CHECK(SBC2DBC("\xa3\xc1\xa3\xe2\xa1\xa1\xa3\xb1") == "Ab 1");        // ⡡
+    CHECK(SBC2DBC("\xd6\xd0\xa1\xa3\xa3\xa4") == "\xd6\xd0.\xa3\xa4");    // С
+    CHECK(SBC2DBC(std::string("x\xa3")) == "x\xa3");
+    CHECK(SBC2DBCUTF8("\xef\xbc\xa1\xef\xbd\x82\xe3\x80\x80\xef\xbd\x9e") == "Ab ~");
+    CHECK(SBC2DBCUTF8("\xe4\xb8\xad\xef\xbd\x9f\xef\xbc") == "\xe4\xb8\xad\xef\xbd\x9f\xef\xbc");
+
+    std::mt19937 rng(49);
+    for (int round = 0; round < 1000; ++round)
+    {
+        std::string gb;
+        std::string expected;
+        size_t count = rng() % 40;
+        for (size_t i = 0; i < count; ++i)
+        {
+            switch (rng() % 4)
+            {
+            case 0:
+                gb += static_cast<char>('a' + rng() % 26);
+                expected += gb.back();
+                break;
+            case 1:
+                gb += "\xd6\xd0";
+                expected += "\xd6\xd0";
+                break;
+            case 2:
+                gb += "\xa1\xa1";
+                expected += ' ';
+                break;
+            default:
+            {
+                // A3A1~A3FDг(A3A4)ⶼжӦİַ
+                unsigned char c2 = 0xa1 + rng() % 93;
+                gb += '\xa3';
+                gb += static_cast<char>(c2);
+                if (c2 == 0xa4)
+                {
+                    expected += "\xa3\xa4";
+                }
+                else
+                {
+                    expected += static_cast<char>(c2 - 0x80);
+                }
+                break;
+            }
+            }
+        }
+        CHECK(SBC2DBC(gb) == expected);
+        std::string copy = gb;
+        CHECK(SBC2DBCInplace(copy) == expected);
+
+        std::string utf8 = FromGB18030(gb);
+        std::string utf8_expected = FromGB18030(expected);
+        CHECK(SBC2DBCUTF8(utf8) == utf8_expected);
+        copy = utf8;
+        CHECK(SBC2DBCUTF8Inplace(copy) == utf8_expected);
+    }
+}
+
+// ·strtod·Ľһ£locale޹
+static void TestParseDouble()
+{
+    double value = 0;
+    CHECK(ParseDouble(" 1.5 ", value) && value == 1.5);
+    CHECK(ParseDouble("+2e3", value) && value == 2000);
+    CHECK(ParseDouble("-0.000123", value) && value == -0.000123);
+    // 19λЧָֻ22ʱ·
+    CHECK(ParseDouble("12345678901234567890123", value) && value == 12345678901234567890123.0);
+    CHECK(ParseDouble("1.7976931348623157e308", value) && value == 1.7976931348623157e308);
+    CHECK(ParseDouble("4.9406564584124654e-324", value) && value == 4.9406564584124654e-324);
+    CHECK(ParseDouble("inf", value) && std::isinf(value));
+
+    value = 7;
+    CHECK(!ParseDouble("", value));
+    CHECK(!ParseDouble("1.5x", value));
+    CHECK(!ParseDouble("0x10", value));
+    CHECK(!ParseDouble("0x1p-1074", value));
+    CHECK(!ParseDouble("1e", value));
+    CHECK(!ParseDouble("+-1", value));
+    CHECK(!ParseDouble("1e400", value));
+    CHECK_EQ(value, 7);
+
+    // СΪŵlocaleӰϵͳûЩlocaleʱ
+    const char* locales[] = { "de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "ru_RU.UTF-8" };
+    for (size_t i = 0; i < sizeof(locales) / sizeof(locales[0]); ++i)
+    {
+        if (setlocale(LC_NUMERIC, locales[i]) == NULL)
+        {
+            continue;
+        }
+        CHECK(ParseDouble("1.5", value) && value == 1.5);
+        CHECK(ParseDouble("1.2345678901234567890123e-300", value) && value == 1.2345678901234567890123e-300);
+        CHECK(!ParseDouble("1,5", value));
+        setlocale(LC_NUMERIC, "C");
+        break;
+    }
+}
+
+//  հ   [.] [e[]] [βַ] ֵıstringstreamstrtodΪͬд
+static std::string RandomNumberText(std::mt19937& rng)
+{
+    std::string text(rng() % 3, ' ');
+    switch (rng() % 3)
+    {
+    case 0: text += '-'; break;
+    case 1: text += '+'; break;
+    default: break;
+    }
+    text += RandomText(rng, 1 + rng() % 22, "0123456789");
+    if (rng() % 2)
+    {
+        text += '.';
+        text += RandomText(rng, rng() % 8, "0123456789");
+    }
+    if (rng() % 3 == 0)
+    {
+        text += rng() % 2 ? "e" : "E-";
+        text += RandomText(rng, 1 + rng() % 2, "0123456789");
+    }
+    if (rng() % 4 == 0)
+    {
+        text += RandomText(rng, 1, "x ,");
+    }
+    return text;
+}
+
+template <typename T>
+static T StreamFromString(const std::string& s)
+{
+    T value = T();
+    std::stringstream ss(s);
+    ss >> value;
+    return value;
+}
+
+template <typename T>
+static std::string StreamToString(const T& value)
+{
+    std::stringstream ss;
+    ss << std::fixed << value;
+    return ss.str();
+}
+
+// from_charsĽӿڣλáͱֵ
+static void TestFromChars()
+{
+    const char* text = "123abc";
+    int64_t i64 = 5;
+    FromCharsResult res = FromChars(text, text + 6, i64);
+    CHECK(res.ec == PARSE_OK && res.ptr == text + 3 && i64 == 123);
+
+    const char* invalid[] = { "", "-", "+1", " 1", "abc" };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i)
+    {
+        const char* s = invalid[i];
+        i64 = 5;
+        res = FromChars(s, s + strlen(s), i64);
+        CHECK(res.ec == PARSE_INVALID && res.ptr == s && i64 == 5);
+    }
+
+    text = "-9223372036854775808";
+    res = FromChars(text, text + strlen(text), i64);
+    CHECK(res.ec == PARSE_OK && i64 == std::numeric_limits<int64_t>::min());
+    text = "9223372036854775808,";
+    res = FromChars(text, text + strlen(text), i64);
+    CHECK(res.ec == PARSE_OUT_OF_RANGE && res.ptr == text + 19 && i64 == std::numeric_limits<int64_t>::max());
+    text = "-9223372036854775809";
+    res = FromChars(text, text + strlen(text), i64);
+    CHECK(res.ec == PARSE_OUT_OF_RANGE && i64 == std::numeric_limits<int64_t>::min());
+
+    uint64_t u64 = 5;
+    text = "18446744073709551615";
+    res = FromChars(text, text + strlen(text), u64);
+    CHECK(res.ec == PARSE_OK && u64 == std::numeric_limits<uint64_t>::max());
+    text = "18446744073709551616";
+    u64 = 5;
+    res = FromChars(text, text + strlen(text), u64);
+    CHECK(res.ec == PARSE_OUT_OF_RANGE && u64 == std::numeric_limits<uint64_t>::max());
+    text = "-1";
+    u64 = 5;
+    res = FromChars(text, text + 2, u64);
+    CHECK(res.ec == PARSE_INVALID && u64 == 5);
+
+    // ָʱֻǰĲ֣lastַ֮
+    double d = 0;
+    text = "1.5e+";
+    res = FromChars(text, text + strlen(text), d);
+    CHECK(res.ec == PARSE_OK && res.ptr == text + 3 && d == 1.5);
+    text = "25";
+    res = FromChars(text, text + 1, d);
+    CHECK(res.ec == PARSE_OK && res.ptr == text + 1 && d == 2);
+    text = ".5";
+    res = FromChars(text, text + 2, d);
+    CHECK(res.ec == PARSE_OK && d == 0.5);
+    text = "-0";
+    res = FromChars(text, text + 2, d);
+    CHECK(res.ec == PARSE_OK && d == 0 && std::signbit(d));
+    text = "Infinity";
+    res = FromChars(text, text + strlen(text), d);
+    CHECK(res.ec == PARSE_OK && res.ptr == text + 8 && std::isinf(d));
+    text = "-NaN";
+    res = FromChars(text, text + 4, d);
+    CHECK(res.ec == PARSE_OK && std::isnan(d));
+    text = "1e400";
+    res = FromChars(text, text + 5, d);
+    CHECK(res.ec == PARSE_OUT_OF_RANGE && res.ptr == text + 5 && d == HUGE_VAL);
+    text = "1e-400";
+    res = FromChars(text, text + 6, d);
+    CHECK(res.ec == PARSE_OUT_OF_RANGE && d == 0);
+    text = ".";
+    d = 3;
+    res = FromChars(text, text + 1, d);
+    CHECK(res.ec == PARSE_INVALID && d == 3);
+}
+
+static void TestNumberValidation()
+{
+    CHECK(isInt(" -42 "));
+    CHECK(isInt("+7"));
+    CHECK(!isInt("1.0"));
+    CHECK(!isInt("9223372036854775808"));
+    CHECK(!isInt(""));
+    CHECK(!isInt("+-1"));
+    CHECK(isFloat("42"));
+    CHECK(isFloat("1e-5"));
+    CHECK(isFloat("-.5"));
+    CHECK(!isFloat("1.5.5"));
+    CHECK(!isFloat("e5"));
+    CHECK(isBool("TRUE"));
+    CHECK(isBool(" off "));
+    CHECK(isBool("0"));
+    CHECK(!isBool("2"));
+    CHECK(!isBool("truee"));
+
+    int64_t i64 = 0;
+    CHECK(ParseInt64("\t-9223372036854775808 ", i64) && i64 == std::numeric_limits<int64_t>::min());
+    uint64_t u64 = 0;
+    CHECK(ParseUInt64("+18446744073709551615", u64) && u64 == std::numeric_limits<uint64_t>::max());
+    CHECK(!ParseUInt64("-1", u64));
+    bool b = false;
+    CHECK(ParseBool("Yes", b) && b);
+    CHECK(ParseBool("oFF", b) && !b);
+}
+
+// ConvertFromString/ConvertToStringػstringstreamͨʵֽһ
+static void TestConvertMatchesStream()
+{
+    std::mt19937 rng(50);
+    for (int round = 0; round < 20000; ++round)
+    {
+        std::string text = RandomNumberText(rng);
+        CHECK_EQ(ConvertFromString<long long>(text), StreamFromString<long long>(text));
+        CHECK_EQ(ConvertFromString<int>(text), StreamFromString<int>(text));
+        CHECK_EQ(ConvertFromString<double>(text), StreamFromString<double>(text));
+        CHECK_EQ(ConvertFromString<float>(text), StreamFromString<float>(text));
+        if (text.find('-') == std::string::npos)
+        {
+            CHECK_EQ(ConvertFromString<unsigned long long>(text), StreamFromString<unsigned long long>(text));
+            CHECK_EQ(ConvertFromString<unsigned int>(text), StreamFromString<unsigned int>(text));
+        }
+    }
+    CHECK_EQ(ConvertFromString<int>("abc"), 0);
+    CHECK_EQ(ConvertFromString<bool>("true"), true);
+    CHECK_EQ(ConvertFromString<bool>(" 12"), true);
+    CHECK_EQ(ConvertFromString<bool>("no"), false);
+
+    for (int round = 0; round < 20000; ++round)
+    {
+        int64_t i = static_cast<int64_t>((static_cast<uint64_t>(rng()) << 32) | rng()) >> (rng() % 64);
+        CHECK_EQ(ConvertToString<long long>(i), StreamToString<long long>(i));
+        CHECK_EQ(ConvertToString<int>(static_cast<int>(i)), StreamToString<int>(static_cast<int>(i)));
+        CHECK_EQ(ConvertToString<unsigned long long>(static_cast<unsigned long long>(i)),
+            StreamToString<unsigned long long>(static_cast<unsigned long long>(i)));
+        double d = std::ldexp(static_cast<double>(i), -static_cast<int>(rng() % 80));
+        CHECK_EQ(ConvertToString<double>(d), StreamToString<double>(d));
+        CHECK_EQ(ConvertToString<float>(static_cast<float>(d)), StreamToString<float>(static_cast<float>(d)));
+    }
+    CHECK_EQ(ConvertToString<double>(1e300), StreamToString<double>(1e300));
+    CHECK_EQ(ConvertToString<bool>(true), "1");
+}
+
+// FormatDouble̱ʾParseDoubleȷԭ
+static void TestFormatDoubleRoundTrip()
+{
+    char buffer[32];
+    CHECK_EQ(std::string(buffer, FormatDouble(0.1, buffer)), "0.1");
+    CHECK_EQ(std::string(buffer, FormatDouble(-2.5, buffer)), "-2.5");
+    CHECK_EQ(std::string(buffer, FormatDouble(100, buffer)), "100");
+    CHECK_EQ(std::string(buffer, FormatDouble(-0.0, buffer)), "-0");
+    CHECK_EQ(std::string(buffer, FormatDouble(HUGE_VAL, buffer)), "inf");
+    CHECK_EQ(std::string(buffer, FormatDouble(-HUGE_VAL, buffer)), "-inf");
+    CHECK_EQ(std::string(buffer, FormatDouble(NAN, buffer)), "nan");
+    CHECK_EQ(std::string(buffer, FormatInt64(std::numeric_limits<int64_t>::min(), buffer)), "-9223372036854775808");
+    CHECK_EQ(std::string(buffer, FormatUInt64(std::numeric_limits<uint64_t>::max(), buffer)), "18446744073709551615");
+
+    std::mt19937_64 rng(50);
+    for (int round = 0; round < 100000; ++round)
+    {
+        double value;
+        if (round % 2)
+        {
+            // λģʽǷǹͼֵ
+            uint64_t bits = rng();
+            memcpy(&value, &bits, sizeof(value));
+            if (!std::isfinite(value))
+            {
+                continue;
+            }
+        }
+        else
+        {
+            // ĶС
+            value = static_cast<double>(static_cast<int64_t>(rng() % 2000001) - 1000000) / 1000;
+        }
+        size_t len = FormatDouble(value, buffer);
+        CHECK(len < 32 && buffer[len] == '\0');
+        double parsed = 0;
+        CHECK(ParseDouble(StringView(buffer, len), parsed));
+        CHECK(memcmp(&parsed, &value, sizeof(value)) == 0);
+        // ʱܻԭС%.*gһ£C locale
+        if (value != std::floor(value) || std::fabs(value) > 9007199254740992.0)
+        {
+            char reference[32];
+            for (int precision = 15; precision <= 17; ++precision)
+            {
+                snprintf(reference, sizeof(reference), "%.*g", precision, value);
+                if (strtod(reference, NULL) == value)
+                {
+                    break;
+                }
+            }
+            CHECK_EQ(std::string(buffer, len), reference);
+        }
+    }
+}
+
+int main()
+{
+    TestSplitView();
+    TestTrim();
+    TestCaseConversion();
+    TestRegexCache();
+    TestMultiPatternMatcher();
+    TestUnicodeTranscode();
+    TestGB18030();
+    TestDetectAndTranscode();
+    TestSBC2DBC();
+    TestParseDouble();
+    TestFromChars();
+    TestNumberValidation();
+    TestConvertMatchesStream();
+    TestFormatDoubleRoundTrip();
+    return TestResult("t_str_helper");
+}
@@ -0,0 +1,60 @@
+#ifndef TEST_HELPER_H
+#define TEST_HELPER_H
+
+#include <cstdio>
+#include <string>
+
+/* õļ򵥶ԣʧʱӡλòmainʧܴ */
+static int g_failed_checks = 0;
+
+#define CHECK(cond) \
+    do \
+    { \
+        if (!(cond)) \
+        { \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++g_failed_checks; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) CHECK((a) == (b))
+
+static inline int TestResult(const char* name)
+{
+    if (g_failed_checks > 0)
+    {
+        printf("%s: %d checks failed\n", name, g_failed_checks);
+        return 1;
+    }
+    printf("%s: all passed\n", name);
+    return 0;
+}
+
+static inline void WriteTestFile(const std::string& path, const std::string& content)
+{
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (fp != NULL)
+    {
+        fwrite(content.data(), 1, content.size(), fp);
+        fclose(fp);
+    }
+}
+
+static inline std::string ReadTestFile(const std::string& path)
+{
+    std::string content;
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (fp != NULL)
+    {
+        char buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+        {
+            content.append(buffer, n);
+        }
+        fclose(fp);
+    }
+    return content;
+}
+
+#endif // TEST_HELPER_H